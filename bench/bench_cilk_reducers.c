@@ -0,0 +1,203 @@
+/*
+** bench_cilk_reducers.c -- mutex against reducer triangle accumulation
+**
+** The enumerating v3 kernels in 2020/ find every triangle (i, j, l) of
+** the lower triangle once and credit all three corners under one
+** pthread mutex (2020/v3_opencilk.c, v3_opencilk_2.c). This runs that
+** loop nest as written and with the same loops accumulating into Cilk
+** reducers instead: an opadd reducer for the total and a reducer of
+** per-strand credit buffers for c3. Both must produce the same counts.
+**
+** Usage: bench_cilk_reducers [repetitions] [martix-market-filename]...
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <cilk/cilk.h>
+#include <cilk/cilk_api.h>
+#include <cilk/reducer.h>
+#include <cilk/reducer_opadd.h>
+#include "bench_common.h"
+#include "../csc_reorder.h"
+
+/*
+** A view is a buffer of credited vertices, added to c3 with atomic adds
+** when it fills up and when its strand joins, so a steal costs one
+** buffer and a join the credits still in it, not a copy of c3. A view
+** whose buffer could not be allocated adds every credit at once.
+*/
+#define CREDIT_BUFFER 4096
+
+typedef struct {
+    int *vertex;
+    int count;
+} vertex_credits;
+
+static int *credit_c3;      /*!< Where every view ends up */
+
+static void vertex_credits_flush(vertex_credits *v){
+    for (int k=0; k<v->count; k++)
+        __atomic_fetch_add(&credit_c3[v->vertex[k]], 1, __ATOMIC_RELAXED);
+    v->count = 0;
+}
+
+static inline void vertex_credits_add(vertex_credits *v, int vertex){
+    if (v->vertex == NULL){
+        __atomic_fetch_add(&credit_c3[vertex], 1, __ATOMIC_RELAXED);
+        return;
+    }
+    v->vertex[v->count] = vertex;
+    if (++v->count == CREDIT_BUFFER)
+        vertex_credits_flush(v);
+}
+
+static void vertex_credits_identity(void *reducer, void *view){
+    ((vertex_credits *)view)->vertex = (int *) malloc(CREDIT_BUFFER * sizeof(int));
+    ((vertex_credits *)view)->count = 0;
+}
+
+static void vertex_credits_reduce(void *reducer, void *left, void *right){
+    vertex_credits_flush((vertex_credits *)right);
+}
+
+static void vertex_credits_destroy(void *reducer, void *view){
+    vertex_credits_flush((vertex_credits *)view);
+    free(((vertex_credits *)view)->vertex);
+}
+
+/* The loop nest of 2020/v3_opencilk_2.c */
+static long v3_mutex(int const *csc_row, int const *csc_col, int N, int *c3){
+    long triangles_found = 0;
+    pthread_mutex_t m;
+    pthread_mutex_init(&m, NULL);
+
+    cilk_for(int i=0; i<N-2; i++){
+        cilk_for(int j=csc_col[i]; j<csc_col[i+1]; j++){
+            for(int k=csc_col[csc_row[j]]; k<csc_col[csc_row[j]+1]; k++){
+                cilk_for(int l=j+1; l<csc_col[i+1]; l++){
+                    if(csc_row[k] == csc_row[l]){
+                        pthread_mutex_lock(&m);
+                        triangles_found++;
+                        c3[i]++;
+                        c3[csc_row[j]]++;
+                        c3[csc_row[l]]++;
+                        pthread_mutex_unlock(&m);
+                    }
+                }
+            }
+        }
+    }
+
+    pthread_mutex_destroy(&m);
+    return triangles_found;
+}
+
+/* The same loops, every strand adding into its own views */
+static long v3_reducer(int const *csc_row, int const *csc_col, int N, int *c3){
+    CILK_C_REDUCER_OPADD(total, long, 0);
+    CILK_C_REGISTER_REDUCER(total);
+
+    credit_c3 = c3;
+    CILK_C_DECLARE_REDUCER(vertex_credits) c3_sum =
+        CILK_C_INIT_REDUCER(vertex_credits, vertex_credits_reduce,
+                            vertex_credits_identity, vertex_credits_destroy,
+                            { (int *) malloc(CREDIT_BUFFER * sizeof(int)), 0 });
+    CILK_C_REGISTER_REDUCER(c3_sum);
+
+    cilk_for(int i=0; i<N-2; i++){
+        cilk_for(int j=csc_col[i]; j<csc_col[i+1]; j++){
+            for(int k=csc_col[csc_row[j]]; k<csc_col[csc_row[j]+1]; k++){
+                cilk_for(int l=j+1; l<csc_col[i+1]; l++){
+                    if(csc_row[k] == csc_row[l]){
+                        vertex_credits *view = &REDUCER_VIEW(c3_sum);
+                        REDUCER_VIEW(total)++;
+                        vertex_credits_add(view, i);
+                        vertex_credits_add(view, csc_row[j]);
+                        vertex_credits_add(view, csc_row[l]);
+                    }
+                }
+            }
+        }
+    }
+
+    // ----- the leftmost view holds the last credits
+    vertex_credits *view = &REDUCER_VIEW(c3_sum);
+    vertex_credits_flush(view);
+    free(view->vertex);
+    view->vertex = NULL;
+    CILK_C_UNREGISTER_REDUCER(c3_sum);
+    long triangles_found = REDUCER_VIEW(total);
+    CILK_C_UNREGISTER_REDUCER(total);
+    return triangles_found;
+}
+
+int main(int argc, char *argv[]){
+
+    struct timespec start;
+    csc_graph G;
+    int repetitions;
+    int failed = 0;
+
+    int first = bench_args(argc, argv, &repetitions, NULL);
+
+    for (int f=first; f<argc; f++){
+        if (csc_graph_load(argv[f], __cilkrts_get_nworkers(), CSC_REORDER_NONE, &G) != 0){
+            failed = 1;
+            continue;
+        }
+        int N = G.N;
+
+        // ----- keep the lower triangle, the layout the v3 kernels expect
+        int *low_row = (int *) malloc((size_t) G.csc_col[N]/2 * sizeof(int) + sizeof(int));
+        int *low_col = (int *) malloc((N+1) * sizeof(int));
+        low_col[0] = 0;
+        for(int j=0, nz=0; j<N; j++){
+            for(int64_t n=G.csc_col[j]; n<G.csc_col[j+1]; n++)
+                if (G.csc_row[n] > j)
+                    low_row[nz++] = G.csc_row[n];
+            low_col[j+1] = nz;
+        }
+        csc_graph_free(&G);
+
+        int *c3_mutex = (int *) malloc(N * sizeof(int));
+        int *c3_reducer = (int *) malloc(N * sizeof(int));
+
+        double best_mutex = 1e30, best_reducer = 1e30;
+        long mutex = 0, reducer = 0;
+        for (int r=0; r<repetitions; r++){
+            memset(c3_mutex, 0, N * sizeof(int));
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            mutex = v3_mutex(low_row, low_col, N, c3_mutex);
+            double t = bench_seconds_since(start);
+            if (t < best_mutex) best_mutex = t;
+
+            memset(c3_reducer, 0, N * sizeof(int));
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            reducer = v3_reducer(low_row, low_col, N, c3_reducer);
+            t = bench_seconds_since(start);
+            if (t < best_reducer) best_reducer = t;
+        }
+
+        int same = mutex == reducer && memcmp(c3_mutex, c3_reducer, N * sizeof(int)) == 0;
+
+        printf("\n%s: N = %d, %d entries in the lower triangle, %ld triangles\n",
+               argv[f], N, low_col[N], mutex);
+        printf("%d workers, best of %d\n", __cilkrts_get_nworkers(), repetitions);
+        printf("mutex per triangle   %8.4f s\n", best_mutex);
+        printf("reducers             %8.4f s  (%.2fx)\n", best_reducer, best_mutex/best_reducer);
+        printf("results %s\n", same ? "identical" : "DIFFER");
+
+        if (!same)
+            failed = 1;
+
+        free(c3_mutex);
+        free(c3_reducer);
+        free(low_row);
+        free(low_col);
+    }
+
+    return failed;
+}
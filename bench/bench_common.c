@@ -0,0 +1,49 @@
+/*
+** bench_common.c -- what the graph benchmarks share
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "../intersect.h"
+
+int bench_args(int argc, char *argv[], int *repetitions, int *nthreads){
+    int opt;
+
+    while ((opt = getopt(argc, argv, (nthreads != NULL) ? "t:" : "")) != -1){
+        if (opt == 't' && atoi(optarg) > 0)
+            *nthreads = atoi(optarg);
+        else
+            optind = argc;
+    }
+
+    if (optind + 2 > argc){
+        fprintf(stderr, "Usage: %s%s [repetitions] [martix-market-filename]...\n",
+                argv[0], (nthreads != NULL) ? " [-t threads]" : "");
+        exit(1);
+    }
+
+    *repetitions = atoi(argv[optind]);
+    if (*repetitions < 1)
+        *repetitions = 1;
+    return optind + 1;
+}
+
+double bench_seconds_since(struct timespec start){
+    struct timespec stop;
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    return (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec)*1e-9;
+}
+
+long bench_masked(const csc_graph *G, int64_t *c3){
+    long total = 0;
+    for (int j = 0; j < G->N; j++){
+        long c = intersect_masked_column(G->csc_row, G->csc_col, G->N, j);
+        if (c3 != NULL)
+            c3[j] = c;
+        total += c;
+    }
+    return total;
+}
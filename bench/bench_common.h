@@ -0,0 +1,36 @@
+/*
+** bench_common.h -- what the graph benchmarks share
+**
+** Every benchmark on graphs is called as
+**
+**     bench_<name> [-t threads] [repetitions] [martix-market-filename]...
+**
+** (-t only where the thread count matters), loads each graph with
+** csc_graph_load like the drivers, cache included, and reports the
+** best time of the repetitions.
+*/
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdint.h>
+#include <time.h>
+#include "../csc_graph.h"
+
+/*
+** Parse the command line above; nthreads is left alone unless -t is
+** given, and NULL rejects -t. Prints the usage and exits when there is
+** no file. Returns the index of the first file in argv.
+*/
+int bench_args(int argc, char *argv[], int *repetitions, int *nthreads);
+
+double bench_seconds_since(struct timespec start);
+
+/*
+** The masked kernel of the drivers, intersect_masked_column on every
+** column. Stores the column sums in c3 unless it is NULL and returns
+** their total, six times the number of triangles.
+*/
+long bench_masked(const csc_graph *G, int64_t *c3);
+
+#endif
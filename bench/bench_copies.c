@@ -0,0 +1,101 @@
+/*
+** bench_copies.c -- masked kernel with and without adjacency copies
+**
+** The masked kernel used to copy the neighbour list of j, and of every
+** neighbour i, into stack VLAs before intersecting them. This runs the
+** kernel both ways on each graph and reports the bytes the copies moved.
+**
+** Usage: bench_copies [repetitions] [martix-market-filename]...
+**        e.g. bench/bench_copies 3 mtx/dblp-2010.mtx mtx/com-Youtube.mtx
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "bench_common.h"
+#include "../csc_reorder.h"
+#include "../intersect.h"
+
+static long masked_copies(int const *csc_row, int64_t const *csc_col, int N){
+    long total = 0;
+    for(int j=0; j<N; j++){
+        int nzrangeOfColA = csc_col[j+1]-csc_col[j];
+        int colA[nzrangeOfColA];
+        for(int64_t y=csc_col[j]; y<csc_col[j+1]; y++)
+            colA[y-csc_col[j]] = csc_row[y];
+
+        for(int64_t n=csc_col[j]; n<csc_col[j+1]; n++){
+            int i = csc_row[n];
+            int nnzrangeOfRowA = csc_col[i+1]-csc_col[i];
+            int rowA[nnzrangeOfRowA];
+            for(int64_t x=csc_col[i]; x<csc_col[i+1]; x++)
+                rowA[x-csc_col[i]] = csc_row[x];
+
+            total += intersect_count(rowA, nnzrangeOfRowA, colA, nzrangeOfColA);
+        }
+    }
+    return total;
+}
+
+int main(int argc, char *argv[]){
+
+    struct timespec start;
+    csc_graph G;
+    int repetitions;
+    int failed = 0;
+
+    int first = bench_args(argc, argv, &repetitions, NULL);
+
+    printf("Intersection: %s\n", intersect_init(NULL));
+
+    // ----- the copying kernel merges every column, so the in-place one does too
+    intersect_hub_degree = 0;
+
+    for (int f=first; f<argc; f++){
+        if (csc_graph_load(argv[f], 1, CSC_REORDER_NONE, &G) != 0){
+            failed = 1;
+            continue;
+        }
+        int N = G.N;
+        int const *csc_row = G.csc_row;
+        int64_t const *csc_col = G.csc_col;
+
+        // ----- every column once, plus the column of i for every entry (i,j)
+        double copied = 0;
+        for(int j=0; j<N; j++){
+            copied += csc_col[j+1]-csc_col[j];
+            for(int64_t n=csc_col[j]; n<csc_col[j+1]; n++)
+                copied += csc_col[csc_row[n]+1]-csc_col[csc_row[n]];
+        }
+        copied *= sizeof(int);
+
+        double best_copies = 1e30, best_in_place = 1e30;
+        long with_copies = 0, in_place = 0;
+        for (int r=0; r<repetitions; r++){
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            with_copies = masked_copies(csc_row, csc_col, N);
+            double t = bench_seconds_since(start);
+            if (t < best_copies) best_copies = t;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            in_place = bench_masked(&G, NULL);
+            t = bench_seconds_since(start);
+            if (t < best_in_place) best_in_place = t;
+        }
+
+        printf("\n%s: N = %d, %" PRId64 " entries, best of %d\n", argv[f], N, csc_col[N], repetitions);
+        printf("with VLA copies  %8.4f s  copies %.1f MB (%.2f GB/s of copy traffic)\n",
+               best_copies, copied/(1024*1024), copied/best_copies/1e9);
+        printf("in place         %8.4f s  copies 0 MB (%.2fx)\n",
+               best_in_place, best_copies/best_in_place);
+        printf("results %s\n", with_copies == in_place ? "identical" : "DIFFER");
+
+        if (with_copies != in_place)
+            failed = 1;
+
+        csc_graph_free(&G);
+    }
+
+    intersect_free_scratch();
+    return failed;
+}
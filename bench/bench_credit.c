@@ -0,0 +1,142 @@
+/*
+** bench_credit.c -- padded atomic counters against per-thread tables
+**
+** Counts each graph with the DAG kernel on 1, 2, 4, ... up to 64 (or
+** -t) threads, crediting the corners of every triangle once through
+** padded atomic counters and once through the per-thread tables of
+** tc_credit.h, whatever TC_CREDIT_AUTO would pick. Times include the
+** merge after the join. Prints the memory of either kind of credits and
+** checks both against the c3 of the single-threaded kernel.
+**
+** Usage: bench_credit [-t max-threads] [repetitions] [martix-market-filename]...
+**        e.g. bench/bench_credit -t 8 3 mtx/dblp-2010.mtx mtx/com-Youtube.mtx
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include "bench_common.h"
+#include "../csc_reorder.h"
+#include "../tc_dag.h"
+
+#define CHUNK 64
+
+typedef struct {
+    int t;
+    int nthreads;
+    const tc_dag *D;
+    tc_credit *C;
+} credit_parm;
+
+/* Count the chunks t, t+nthreads, t+2*nthreads, ... */
+static void *count_chunks(void *arg){
+    credit_parm *p = (credit_parm *)arg;
+    int n = p->D->n;
+
+    for(int lo=p->t*CHUNK; lo<n; lo+=p->nthreads*CHUNK){
+        int hi = (lo + CHUNK < n) ? lo + CHUNK : n;
+        tc_dag_count_credit(p->D, lo, hi, p->C, p->t);
+    }
+    return NULL;
+}
+
+/* Best time of repetitions runs with credits of mode; -1 when out of memory */
+static double run(const tc_dag *D, int mode, int nthreads, int repetitions, int64_t *c3){
+    pthread_t threads[nthreads];
+    credit_parm parms[nthreads];
+    struct timespec start;
+    tc_credit C;
+    double best = 1e30;
+
+    for (int r=0; r<repetitions; r++){
+        memset(c3, 0, (size_t) D->n * sizeof(int64_t));
+        if (tc_credit_init(&C, D->n, nthreads, mode, c3) != 0)
+            return -1;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int t=0; t<nthreads; t++){
+            parms[t] = (credit_parm){ t, nthreads, D, &C };
+            pthread_create(&threads[t], NULL, count_chunks, &parms[t]);
+        }
+        for(int t=0; t<nthreads; t++)
+            pthread_join(threads[t], NULL);
+        tc_credit_finish(&C);
+        double seconds = bench_seconds_since(start);
+
+        tc_credit_free(&C);
+        if (seconds < best) best = seconds;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]){
+
+    csc_graph G;
+    int repetitions;
+    int max_threads = 64;
+    int failed = 0;
+
+    int first = bench_args(argc, argv, &repetitions, &max_threads);
+
+    for (int f=first; f<argc; f++){
+        if (csc_graph_load(argv[f], 1, CSC_REORDER_NONE, &G) != 0){
+            failed = 1;
+            continue;
+        }
+        int N = G.N;
+
+        tc_dag D;
+        if (tc_dag_build(G.csc_row, G.csc_col, N, &D) != 0){
+            printf("Could not allocate the DAG of %d vertices.\n", N);
+            csc_graph_free(&G);
+            failed = 1;
+            continue;
+        }
+
+        int64_t *c3 = (int64_t *) malloc((size_t)(N > 0 ? N : 1) * sizeof(int64_t));
+        int64_t *c3_ref = (int64_t *) calloc((size_t)(N > 0 ? N : 1), sizeof(int64_t));
+        if (c3 == NULL || c3_ref == NULL){
+            printf("Could not allocate the counts of %d vertices.\n", N);
+            free(c3);
+            free(c3_ref);
+            tc_dag_free(&D);
+            csc_graph_free(&G);
+            failed = 1;
+            continue;
+        }
+        long triangles = tc_dag_count(&D, 0, N, c3_ref);
+
+        printf("\n%s: N = %d, %" PRId64 " entries, %ld triangles, best of %d\n",
+               argv[f], N, G.csc_col[N], triangles, repetitions);
+        printf("threads  atomic MB  atomic (s)  tables MB  tables (s)  atomic/tables\n");
+
+        for (int nthreads=1; nthreads<=max_threads; nthreads*=2){
+            double atomic = run(&D, TC_CREDIT_ATOMIC, nthreads, repetitions, c3);
+            int same_atomic = memcmp(c3, c3_ref, (size_t) N * sizeof(int64_t)) == 0;
+            double tables = run(&D, TC_CREDIT_BUFFERED, nthreads, repetitions, c3);
+            int same_tables = memcmp(c3, c3_ref, (size_t) N * sizeof(int64_t)) == 0;
+            if (atomic < 0 || tables < 0){
+                printf("%7d  could not allocate the credits\n", nthreads);
+                failed = 1;
+                break;
+            }
+
+            double atomic_mb = (double) N * sizeof(tc_credit_counter)/(1024.0*1024.0);
+            double tables_mb = (double) nthreads * TC_CREDIT_SLOTS * sizeof(tc_credit_slot)/(1024.0*1024.0);
+            printf("%7d  %9.1f  %10.4f  %9.1f  %10.4f  %12.2fx%s\n", nthreads,
+                   atomic_mb, atomic, tables_mb, tables, atomic/tables,
+                   same_atomic && same_tables ? "" : "  results DIFFER");
+            if (!same_atomic || !same_tables)
+                failed = 1;
+        }
+
+        free(c3);
+        free(c3_ref);
+        tc_dag_free(&D);
+        csc_graph_free(&G);
+    }
+
+    return failed;
+}
@@ -0,0 +1,159 @@
+/*
+** bench_false_sharing.c -- packed against padded per-thread counters
+**
+** The pthreads driver used to keep every thread's running count in a
+** packed parm array and add to it after each intersection, so threads
+** next to each other kept writing to the same cache line. This counts
+** each graph with 1, 2, 4, ... up to 64 (or -t) threads both that way
+** and with counters that are accumulated in a register and written once
+** per range into their own cache line.
+**
+** Usage: bench_false_sharing [-t max-threads] [repetitions] [martix-market-filename]...
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include "bench_common.h"
+#include "../csc_reorder.h"
+#include "../intersect.h"
+
+#define CHUNK 64
+
+/* The old layout: counters of neighbouring threads share cache lines */
+typedef struct {
+    int t;
+    int nthreads;
+    int n;
+    int *csc_row;
+    int64_t *csc_col;
+    long c;
+} packed_parm;
+
+/* The new layout: one cache line per thread */
+typedef struct {
+    int t;
+    int nthreads;
+    int n;
+    int *csc_row;
+    int64_t *csc_col;
+    long c;
+} __attribute__((aligned(64))) padded_parm;
+
+/* Both variants count the chunks t, t+nthreads, t+2*nthreads, ... */
+static void *count_packed(void *arg){
+    packed_parm *p = (packed_parm *)arg;
+    int *row = p->csc_row;
+    int64_t *col = p->csc_col;
+
+    for(int lo=p->t*CHUNK; lo<p->n; lo+=p->nthreads*CHUNK){
+        int hi = (lo + CHUNK < p->n) ? lo + CHUNK : p->n;
+        for(int j=lo; j<hi; j++)
+            for(int64_t n=col[j]; n<col[j+1]; n++){
+                int i = row[n];
+                p->c += intersect_count(row + col[i], col[i+1]-col[i],
+                                        row + col[j], col[j+1]-col[j]);
+            }
+    }
+    return NULL;
+}
+
+static void *count_padded(void *arg){
+    padded_parm *p = (padded_parm *)arg;
+    int *row = p->csc_row;
+    int64_t *col = p->csc_col;
+
+    for(int lo=p->t*CHUNK; lo<p->n; lo+=p->nthreads*CHUNK){
+        int hi = (lo + CHUNK < p->n) ? lo + CHUNK : p->n;
+        long c = 0;
+        for(int j=lo; j<hi; j++)
+            for(int64_t n=col[j]; n<col[j+1]; n++){
+                int i = row[n];
+                c += intersect_count(row + col[i], col[i+1]-col[i],
+                                     row + col[j], col[j+1]-col[j]);
+            }
+        p->c += c;
+    }
+    return NULL;
+}
+
+static double run(void *(*fn)(void *), void *parms, size_t size, int nthreads, long *total){
+    pthread_t threads[nthreads];
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int t=0; t<nthreads; t++)
+        pthread_create(&threads[t], NULL, fn, (char *)parms + t*size);
+    for(int t=0; t<nthreads; t++)
+        pthread_join(threads[t], NULL);
+    double seconds = bench_seconds_since(start);
+
+    // ----- c is the last field of both layouts
+    *total = 0;
+    for(int t=0; t<nthreads; t++)
+        *total += ((packed_parm *)((char *)parms + t*size))->c;
+    return seconds;
+}
+
+int main(int argc, char *argv[]){
+
+    csc_graph G;
+    int repetitions;
+    int max_threads = 64;
+    int failed = 0;
+
+    int first = bench_args(argc, argv, &repetitions, &max_threads);
+
+    printf("Intersection: %s\n", intersect_init(NULL));
+
+    for (int f=first; f<argc; f++){
+        if (csc_graph_load(argv[f], 1, CSC_REORDER_NONE, &G) != 0){
+            failed = 1;
+            continue;
+        }
+        int N = G.N;
+        int *csc_row = G.csc_row;
+        int64_t *csc_col = G.csc_col;
+        printf("\n%s: N = %d, %" PRId64 " entries, best of %d\n", argv[f], N, csc_col[N], repetitions);
+        printf("threads    packed (s)   padded (s)   packed/padded\n");
+
+        double base_packed = 0, base_padded = 0;
+        for (int nthreads=1; nthreads<=max_threads; nthreads*=2){
+            packed_parm *packed = (packed_parm *) malloc(nthreads*sizeof(packed_parm));
+            padded_parm *padded = (padded_parm *) aligned_alloc(64, nthreads*sizeof(padded_parm));
+
+            double best_packed = 1e30, best_padded = 1e30;
+            long packed_total = 0, padded_total = 0;
+            for (int r=0; r<repetitions; r++){
+                for(int t=0; t<nthreads; t++){
+                    packed[t] = (packed_parm){ t, nthreads, N, csc_row, csc_col, 0 };
+                    padded[t] = (padded_parm){ t, nthreads, N, csc_row, csc_col, 0 };
+                }
+                double s = run(count_packed, packed, sizeof(packed_parm), nthreads, &packed_total);
+                if (s < best_packed) best_packed = s;
+                s = run(count_padded, padded, sizeof(padded_parm), nthreads, &padded_total);
+                if (s < best_padded) best_padded = s;
+            }
+            if (nthreads == 1){
+                base_packed = best_packed;
+                base_padded = best_padded;
+            }
+
+            printf("%7d  %9.4f (%5.2fx)  %9.4f (%5.2fx)  %.2fx%s\n", nthreads,
+                   best_packed, base_packed/best_packed, best_padded, base_padded/best_padded,
+                   best_packed/best_padded, packed_total == padded_total ? "" : "  results DIFFER");
+            if (packed_total != padded_total)
+                failed = 1;
+
+            free(packed);
+            free(padded);
+        }
+
+        csc_graph_free(&G);
+    }
+
+    intersect_free_scratch();
+
+    return failed;
+}
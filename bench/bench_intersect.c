@@ -0,0 +1,93 @@
+/*
+** bench_intersect.c -- sorted-set intersection microbenchmark
+**
+** Runs every intersection routine on synthetic pairs of sorted lists,
+** from short balanced pairs to a short list meeting a hub, and checks
+** that all routines agree with the scalar merge. "adaptive" is what the
+** kernels call: the selected merge or galloping, by length ratio.
+**
+** Usage: bench_intersect [repetitions]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bench_common.h"
+#include "../intersect.h"
+
+/* Sorted list of len distinct values drawn from [0, range) */
+static int *random_list(int len, int range){
+    int *list = (int *) malloc(len * sizeof(int));
+    int step = range / len;
+    for (int k = 0, v = 0; k < len; k++){
+        v += 1 + rand() % (2*step > 1 ? 2*step - 1 : 1);
+        list[k] = v;
+    }
+    return list;
+}
+
+int main(int argc, char *argv[]){
+
+    int const pairs[][2] = {
+        {8, 8}, {32, 32}, {100, 100}, {1000, 1000}, {28000, 28000},
+        {3, 28000}, {100, 28000}, {1000, 28000}, {2000, 28000}, {4000, 28000}
+    };
+    int const npairs = sizeof(pairs) / sizeof(pairs[0]);
+
+    struct { const char *name; intersect_fn fn; } all[] = {
+        {"scalar", intersect_scalar},
+        {"galloping", intersect_galloping},
+        {"avx2", intersect_avx2},
+        {"avx512", intersect_avx512},
+        {"adaptive", intersect_count},
+    }, routines[5];
+    int nroutines = 0;
+
+    long work = (argc > 1) ? atol(argv[1]) : 50000000;
+
+    // ----- only time the routines this CPU can run
+    for (int r = 0; r < 5; r++)
+        if ((all[r].fn != intersect_avx2 && all[r].fn != intersect_avx512) ||
+            intersect_init(all[r].name) != NULL)
+            routines[nroutines++] = all[r];
+
+    printf("selected: %s, galloping above a length ratio of %d\n",
+           intersect_init(NULL), intersect_skew);
+    printf("%7s %7s %8s", "len(a)", "len(b)", "common");
+    for (int r = 0; r < nroutines; r++)
+        printf(" %12s", routines[r].name);
+    printf("   (ns per call)\n");
+
+    srand(42);
+    int status = 0;
+    for (int p = 0; p < npairs; p++){
+        int na = pairs[p][0], nb = pairs[p][1];
+        int range = 4 * (na > nb ? na : nb);
+        int *a = random_list(na, range);
+        int *b = random_list(nb, range);
+        int expected = intersect_scalar(a, na, b, nb);
+        long calls = work / (na + nb) + 1;
+
+        printf("%7d %7d %8d", na, nb, expected);
+        for (int r = 0; r < nroutines; r++){
+            struct timespec start;
+            long sum = 0;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (long c = 0; c < calls; c++)
+                sum += routines[r].fn(a, na, b, nb);
+            double t = bench_seconds_since(start);
+
+            if (sum != expected * calls){
+                printf(" %12s", "WRONG");
+                status = 1;
+            }else
+                printf(" %12.1f", t / calls * 1e9);
+        }
+        printf("\n");
+
+        free(a);
+        free(b);
+    }
+
+    return status;
+}
@@ -0,0 +1,83 @@
+/*
+** bench_kernels.c -- masked merge against dense bitmap marking
+**
+** Runs the masked kernel, which merges the neighbour lists of j and of
+** every neighbour i, and the bitmap kernel, which marks the rows of j
+** once and probes every neighbour list against the marks, on each of
+** the given graphs and checks that both count the same triangles.
+**
+** Usage: bench_kernels [repetitions] [martix-market-filename]...
+**        e.g. bench/bench_kernels 3 mtx/dblp-2010.mtx mtx/com-Youtube.mtx
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "bench_common.h"
+#include "../csc_reorder.h"
+#include "../intersect.h"
+
+static long bitmap_marking(const csc_graph *G, intersect_bitmap *marks){
+    long total = 0;
+    for(int j=0; j<G->N; j++)
+        total += intersect_bitmap_column(marks, G->csc_row, G->csc_col, j);
+    return total;
+}
+
+int main(int argc, char *argv[]){
+
+    struct timespec start;
+    csc_graph G;
+    int repetitions;
+    int failed = 0;
+
+    int first = bench_args(argc, argv, &repetitions, NULL);
+
+    printf("Intersection: %s\n", intersect_init(NULL));
+
+    // ----- merge every column, hubs included, so the masked side never marks
+    intersect_hub_degree = 0;
+
+    for (int f=first; f<argc; f++){
+        if (csc_graph_load(argv[f], 1, CSC_REORDER_NONE, &G) != 0){
+            failed = 1;
+            continue;
+        }
+        intersect_bitmap *marks = intersect_bitmap_acquire(G.N);
+        if (marks == NULL){
+            printf("Could not allocate the bitmap of %d vertices.\n", G.N);
+            csc_graph_free(&G);
+            failed = 1;
+            continue;
+        }
+
+        double best_masked = 1e30, best_bitmap = 1e30;
+        long masked = 0, bitmap = 0;
+        for (int r=0; r<repetitions; r++){
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            masked = bench_masked(&G, NULL);
+            double t = bench_seconds_since(start);
+            if (t < best_masked) best_masked = t;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            bitmap = bitmap_marking(&G, marks);
+            t = bench_seconds_since(start);
+            if (t < best_bitmap) best_bitmap = t;
+        }
+
+        printf("\n%s: N = %d, %" PRId64 " entries, %ld triangles, best of %d\n",
+               argv[f], G.N, G.csc_col[G.N], masked/6, repetitions);
+        printf("masked merge     %8.4f s\n", best_masked);
+        printf("bitmap marking   %8.4f s  (%.2fx)\n", best_bitmap, best_masked/best_bitmap);
+        printf("results %s\n", masked == bitmap ? "identical" : "DIFFER");
+
+        if (masked != bitmap)
+            failed = 1;
+
+        intersect_bitmap_release(marks);
+        csc_graph_free(&G);
+    }
+
+    intersect_free_scratch();
+    return failed;
+}
@@ -0,0 +1,117 @@
+/*
+** bench_reorder.c -- masked kernel after every vertex order
+**
+** Relabels each graph with every order of csc_reorder.h, times the
+** permutation, the rebuild of the CSC and the masked kernel on the
+** result, maps c3 back to the ids of the file and checks it against
+** the counts in the original order.
+**
+** Usage: bench_reorder [repetitions] [martix-market-filename]...
+**        e.g. bench/bench_reorder 3 mtx/belgium_osm.mtx mtx/com-Youtube.mtx
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "bench_common.h"
+#include "../csc_reorder.h"
+#include "../intersect.h"
+
+int main(int argc, char *argv[]){
+
+    struct timespec start;
+    csc_graph G;
+    int repetitions;
+    int failed = 0;
+
+    int first = bench_args(argc, argv, &repetitions, NULL);
+
+    printf("Intersection: %s\n", intersect_init(NULL));
+
+    for (int f=first; f<argc; f++){
+        if (csc_graph_load(argv[f], 1, CSC_REORDER_NONE, &G) != 0){
+            failed = 1;
+            continue;
+        }
+        int N = G.N;
+        if (N == 0){
+            csc_graph_free(&G);
+            continue;
+        }
+
+        printf("\n%s: N = %d, %" PRId64 " entries, best of %d\n",
+               argv[f], N, G.csc_col[N], repetitions);
+        printf("order     order (s)  rebuild (s)  kernel (s)  speedup  incl. reorder\n");
+
+        int64_t *c3 = (int64_t *) malloc((size_t) N * sizeof(int64_t));
+        int64_t *c3_none = (int64_t *) malloc((size_t) N * sizeof(int64_t));
+        if (c3 == NULL || c3_none == NULL){
+            printf("Could not allocate the counts of %d vertices.\n", N);
+            free(c3);
+            free(c3_none);
+            csc_graph_free(&G);
+            failed = 1;
+            continue;
+        }
+        double base = 0;
+
+        for (int order=CSC_REORDER_NONE; order<=CSC_REORDER_GORDER; order++){
+            csc_graph R = G;
+            double t_order = 0, t_rebuild = 0;
+
+            if (order != CSC_REORDER_NONE){
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                R.perm = csc_reorder_perm(G.csc_row, G.csc_col, N, order);
+                t_order = bench_seconds_since(start);
+                if (R.perm == NULL){
+                    printf("%-8s  could not allocate the order\n", csc_reorder_name(order));
+                    failed = 1;
+                    continue;
+                }
+
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                int ret = csc_reorder_apply(G.csc_row, G.csc_col, N, R.perm, 1, &R.csc_row, &R.csc_col);
+                t_rebuild = bench_seconds_since(start);
+                if (ret != 0){
+                    printf("%-8s  could not allocate the relabelled graph\n", csc_reorder_name(order));
+                    free(R.perm);
+                    failed = 1;
+                    continue;
+                }
+                R.cache.map = NULL;
+            }
+
+            double best = 1e30;
+            for (int r=0; r<repetitions; r++){
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                bench_masked(&R, c3);
+                double t = bench_seconds_since(start);
+                if (t < best) best = t;
+            }
+
+            int same = 1;
+            if (order == CSC_REORDER_NONE){
+                base = best;
+                memcpy(c3_none, c3, (size_t) N * sizeof(int64_t));
+            }else{
+                csc_graph_restore(&R, c3);
+                same = memcmp(c3, c3_none, (size_t) N * sizeof(int64_t)) == 0;
+                csc_graph_free(&R);
+            }
+
+            printf("%-8s  %9.4f  %11.4f  %10.4f  %6.2fx  %12.2fx%s\n", csc_reorder_name(order),
+                   t_order, t_rebuild, best, base/best, base/(t_order + t_rebuild + best),
+                   same ? "" : "  results DIFFER");
+            if (!same)
+                failed = 1;
+        }
+
+        free(c3);
+        free(c3_none);
+        csc_graph_free(&G);
+    }
+
+    intersect_free_scratch();
+    return failed;
+}
@@ -0,0 +1,93 @@
+/*
+** bench_varint.c -- plain against gap-encoded adjacency
+**
+** Runs the masked kernel on csc_row as it is and on the varint encoded
+** lists of csc_varint.h, on each of the given graphs. Prints the size
+** of both layouts, the time of the encoding and of both kernels, and
+** checks that both count the same triangles.
+**
+** Usage: bench_varint [repetitions] [martix-market-filename]...
+**        e.g. bench/bench_varint 3 mtx/dblp-2010.mtx mtx/com-Youtube.mtx
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "bench_common.h"
+#include "../csc_reorder.h"
+#include "../csc_varint.h"
+#include "../intersect.h"
+
+static long masked_varint(const csc_varint *V, int N){
+    long total = 0;
+    for(int j=0; j<N; j++)
+        total += csc_varint_column(V, j, 0);
+    return total;
+}
+
+int main(int argc, char *argv[]){
+
+    struct timespec start;
+    csc_graph G;
+    csc_varint V;
+    int repetitions;
+    int failed = 0;
+
+    int first = bench_args(argc, argv, &repetitions, NULL);
+
+    printf("Intersection: %s\n", intersect_init(NULL));
+
+    // ----- the varint kernel has no hub path, so the plain one merges every column too
+    intersect_hub_degree = 0;
+
+    for (int f=first; f<argc; f++){
+        if (csc_graph_load(argv[f], 1, CSC_REORDER_NONE, &G) != 0){
+            failed = 1;
+            continue;
+        }
+        int N = G.N;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (csc_varint_build(G.csc_row, G.csc_col, N, 1, &V) != 0){
+            printf("Could not encode %s.\n", argv[f]);
+            failed = 1;
+            csc_graph_free(&G);
+            continue;
+        }
+        double encode = bench_seconds_since(start);
+
+        double best_plain = 1e30, best_varint = 1e30;
+        long plain = 0, varint = 0;
+        for (int r=0; r<repetitions; r++){
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            plain = bench_masked(&G, NULL);
+            double t = bench_seconds_since(start);
+            if (t < best_plain) best_plain = t;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            varint = masked_varint(&V, N);
+            t = bench_seconds_since(start);
+            if (t < best_varint) best_varint = t;
+        }
+
+        double plain_mb = csc_graph_bytes(&G)/(1024.0*1024.0);
+        double varint_mb = csc_varint_bytes(&V)/(1024.0*1024.0);
+
+        printf("\n%s: N = %d, %" PRId64 " entries, %ld triangles, best of %d\n",
+               argv[f], N, G.csc_col[N], plain/6, repetitions);
+        printf("plain CSC    %8.1f MB  %8.4f s\n", plain_mb, best_plain);
+        printf("varint       %8.1f MB  %8.4f s  (%.2fx smaller, %.2fx the speed, %.4f s to encode)\n",
+               varint_mb, best_varint, plain_mb/varint_mb, best_plain/best_varint, encode);
+        printf("bytes per entry: %.2f\n", (double)(V.col[N]) / (G.csc_col[N] > 0 ? G.csc_col[N] : 1));
+        printf("results %s\n", plain == varint ? "identical" : "DIFFER");
+
+        if (plain != varint)
+            failed = 1;
+
+        csc_varint_free(&V);
+        csc_graph_free(&G);
+    }
+
+    intersect_free_scratch();
+    return failed;
+}
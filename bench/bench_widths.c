@@ -0,0 +1,106 @@
+/*
+** bench_widths.c -- DAG kernel with narrow and wide index types
+**
+** Builds the degree-ordered DAG of each graph in every layout of
+** tc_dag.h that can hold it (16-bit ranks and 32-bit offsets, 32/32,
+** 32/64) and times the same counting loop on each. The rate is the
+** bytes of the widest layout over the time, the same amount of graph
+** for every row, so a faster layout always shows a higher rate; all
+** layouts must find the same triangles and c3.
+**
+** Usage: bench_widths [repetitions] [martix-market-filename]...
+**        e.g. bench/bench_widths 3 mtx/dblp-2010.mtx mtx/com-Youtube.mtx
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "bench_common.h"
+#include "../csc_reorder.h"
+#include "../tc_dag.h"
+
+int main(int argc, char *argv[]){
+
+    struct timespec start;
+    csc_graph G;
+    int repetitions;
+    int failed = 0;
+
+    int first = bench_args(argc, argv, &repetitions, NULL);
+
+    for (int f=first; f<argc; f++){
+        if (csc_graph_load(argv[f], 1, CSC_REORDER_NONE, &G) != 0){
+            failed = 1;
+            continue;
+        }
+        int N = G.N;
+        int const *csc_row = G.csc_row;
+        int64_t const *csc_col = G.csc_col;
+
+        printf("\n%s: N = %d, %" PRId64 " entries, best of %d\n",
+               argv[f], N, csc_col[N], repetitions);
+        printf("layout                           index MB   time (s)  wide MB/s\n");
+
+        int64_t *c3 = (int64_t *) malloc((size_t) N * sizeof(int64_t));
+        int64_t *c3_wide = (int64_t *) malloc((size_t) N * sizeof(int64_t));
+        if (c3 == NULL || c3_wide == NULL){
+            printf("Could not allocate the counts of %d vertices.\n", N);
+            free(c3);
+            free(c3_wide);
+            csc_graph_free(&G);
+            failed = 1;
+            continue;
+        }
+        long wide = -1;
+        double best_wide = 0, wide_mb = 0;
+
+        // ----- widest first, so every narrower layout is checked against it
+        for (int width=TC_DAG_WIDTH_32_64; width>=TC_DAG_WIDTH_16_32; width--){
+            tc_dag D;
+            if (tc_dag_build_width(csc_row, csc_col, N, width, &D) != 0){
+                printf("%-32s could not allocate the DAG\n", tc_dag_width_name(width));
+                failed = 1;
+                continue;
+            }
+            if (D.width != width){
+                printf("%-32s does not fit\n", tc_dag_width_name(width));
+                tc_dag_free(&D);
+                continue;
+            }
+
+            double best = 1e30;
+            long triangles = 0;
+            for (int r=0; r<repetitions; r++){
+                memset(c3, 0, (size_t) N * sizeof(int64_t));
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                triangles = tc_dag_count(&D, 0, N, c3);
+                double t = bench_seconds_since(start);
+                if (t < best) best = t;
+            }
+
+            double mb = tc_dag_bytes(&D)/(1024.0*1024.0);
+            if (wide < 0){
+                wide = triangles;
+                best_wide = best;
+                wide_mb = mb;
+                memcpy(c3_wide, c3, (size_t) N * sizeof(int64_t));
+            }
+            int same = triangles == wide && memcmp(c3, c3_wide, (size_t) N * sizeof(int64_t)) == 0;
+
+            printf("%-32s %8.1f  %9.4f  %9.0f  (%.2fx)%s\n", tc_dag_width_name(width),
+                   mb, best, wide_mb/best, best_wide/best, same ? "" : "  results DIFFER");
+            if (!same)
+                failed = 1;
+
+            tc_dag_free(&D);
+        }
+        printf("%ld triangles\n", wide);
+
+        free(c3);
+        free(c3_wide);
+        csc_graph_free(&G);
+    }
+
+    return failed;
+}
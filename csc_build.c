@@ -0,0 +1,524 @@
+/*
+** csc_build.c -- construction of the CSC adjacency from COO entries
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "csc_build.h"
+
+void coo2csc(
+    int       * const row,       /*!< CSC row start indices */
+    int64_t   * const col,       /*!< CSC column indices */
+    int const * const row_coo,   /*!< COO row indices */
+    int const * const col_coo,   /*!< COO column indices */
+    int64_t const     nnz,       /*!< Number of nonzero elements */
+    int const         n,         /*!< Number of rows/columns */
+    int const         isOneBased /*!< Whether COO is 0- or 1-based */
+) {
+
+    // ----- cannot assume that input is already 0!
+    for (int l = 0; l < n+1; l++) col[l] = 0;
+
+    // ----- find the correct column sizes
+    for (int64_t l = 0; l < nnz; l++)
+        col[col_coo[l] - isOneBased]++;
+
+    // ----- cumulative sum
+    int64_t cumsum = 0;
+    for (int i = 0; i < n; i++){
+        int64_t temp = col[i];
+        col[i] = cumsum;
+        cumsum += temp;
+    }
+    col[n] = nnz;
+
+    // ----- copy the row indices to the correct place
+    for (int64_t l=0; l < nnz; l++){
+        int col_l;
+        col_l = col_coo[l] - isOneBased;
+
+        int64_t dst = col[col_l];
+        row[dst] = row_coo[l] - isOneBased;
+
+        col[col_l]++;
+    }
+
+    // ----- revert the column pointers
+    int64_t last = 0;
+    for (int i=0; i<n; i++){
+        int64_t temp = col[i];
+        col[i] = last;
+        last = temp;
+    }
+}
+
+/*
+** Symmetric version of coo2csc: every COO entry (i,j) is stored as both
+** (i,j) and (j,i). The result is the same as coo2csc on the 2*nnz
+** entries [row_coo col_coo; col_coo row_coo], without building them.
+*/
+void coo2csc_symmetric(
+    int       * const row,       /*!< CSC row start indices */
+    int64_t   * const col,       /*!< CSC column indices */
+    int const * const row_coo,   /*!< COO row indices */
+    int const * const col_coo,   /*!< COO column indices */
+    int64_t const     nnz,       /*!< Number of nonzero elements */
+    int const         n,         /*!< Number of rows/columns */
+    int const         isOneBased /*!< Whether COO is 0- or 1-based */
+) {
+
+    // ----- cannot assume that input is already 0!
+    for (int l = 0; l < n+1; l++) col[l] = 0;
+
+    // ----- find the correct column sizes, counting both directions
+    for (int64_t l = 0; l < nnz; l++){
+        col[col_coo[l] - isOneBased]++;
+        col[row_coo[l] - isOneBased]++;
+    }
+
+    // ----- cumulative sum
+    int64_t cumsum = 0;
+    for (int i = 0; i < n; i++){
+        int64_t temp = col[i];
+        col[i] = cumsum;
+        cumsum += temp;
+    }
+    col[n] = 2*nnz;
+
+    // ----- copy the row indices of (i,j), then of the mirrored (j,i)
+    for (int64_t l=0; l < nnz; l++){
+        int col_l = col_coo[l] - isOneBased;
+        row[col[col_l]++] = row_coo[l] - isOneBased;
+    }
+    for (int64_t l=0; l < nnz; l++){
+        int col_l = row_coo[l] - isOneBased;
+        row[col[col_l]++] = col_coo[l] - isOneBased;
+    }
+
+    // ----- revert the column pointers
+    int64_t last = 0;
+    for (int i=0; i<n; i++){
+        int64_t temp = col[i];
+        col[i] = last;
+        last = temp;
+    }
+}
+
+typedef struct {
+    int id;
+    int nthreads;
+    int *row;
+    int64_t *col;
+    int const *row_coo;
+    int const *col_coo;
+    int64_t nnz;
+    int n;
+    int isOneBased;
+    int symmetric;              /*!< Whether the mirrored entries follow the COO ones */
+    int64_t *hist;              /*!< nthreads x n cursors, row-major by thread */
+    int64_t *block_sum;         /*!< Entries in each thread's column block */
+    pthread_barrier_t *barrier;
+} coo2csc_worker;
+
+static void *coo2csc_thread(void *arg){
+    coo2csc_worker *w = (coo2csc_worker *)arg;
+    int const t = w->id, T = w->nthreads, n = w->n, base = w->isOneBased;
+    int64_t const nnz = w->nnz, total = w->symmetric ? 2*nnz : nnz;
+
+    // ----- this thread's share of the (logical) entries and of the columns
+    int64_t const lo = total * t / T, hi = total * (t+1) / T;
+    int const c_lo = (int)((long) n * t / T), c_hi = (int)((long) n * (t+1) / T);
+    int64_t *hist = w->hist + (long) t * n;
+    int64_t *col = w->col;
+
+    // ----- per-thread column sizes; segment 1 holds the mirrored entries
+    for (int c = 0; c < n; c++) hist[c] = 0;
+    for (int s = 0; s <= w->symmetric; s++){
+        int const *cols = s ? w->row_coo : w->col_coo;
+        int64_t l_lo = (lo - s*nnz > 0) ? lo - s*nnz : 0;
+        int64_t l_hi = (hi - s*nnz < nnz) ? hi - s*nnz : nnz;
+        for (int64_t l = l_lo; l < l_hi; l++)
+            hist[cols[l] - base]++;
+    }
+
+    pthread_barrier_wait(w->barrier);
+
+    // ----- turn the histograms into offsets inside each column
+    int64_t block = 0;
+    for (int c = c_lo; c < c_hi; c++){
+        int64_t sum = 0;
+        for (int u = 0; u < T; u++){
+            int64_t temp = w->hist[(long) u * n + c];
+            w->hist[(long) u * n + c] = sum;
+            sum += temp;
+        }
+        col[c] = sum;
+        block += sum;
+    }
+    w->block_sum[t] = block;
+
+    pthread_barrier_wait(w->barrier);
+
+    // ----- cumulative sum: blocks before this one, then inside the block
+    int64_t cumsum = 0;
+    for (int u = 0; u < t; u++)
+        cumsum += w->block_sum[u];
+    for (int c = c_lo; c < c_hi; c++){
+        int64_t temp = col[c];
+        col[c] = cumsum;
+        cumsum += temp;
+        for (int u = 0; u < T; u++)
+            w->hist[(long) u * n + c] += col[c];
+    }
+    if (t == T-1)
+        col[n] = total;
+
+    pthread_barrier_wait(w->barrier);
+
+    // ----- copy the row indices to the correct place
+    for (int s = 0; s <= w->symmetric; s++){
+        int const *rows = s ? w->col_coo : w->row_coo;
+        int const *cols = s ? w->row_coo : w->col_coo;
+        int64_t l_lo = (lo - s*nnz > 0) ? lo - s*nnz : 0;
+        int64_t l_hi = (hi - s*nnz < nnz) ? hi - s*nnz : nnz;
+        for (int64_t l = l_lo; l < l_hi; l++){
+            int col_l = cols[l] - base;
+            w->row[hist[col_l]++] = rows[l] - base;
+        }
+    }
+
+    return NULL;
+}
+
+static void coo2csc_run(
+    int       * const row,
+    int64_t   * const col,
+    int const * const row_coo,
+    int const * const col_coo,
+    int64_t const     nnz,
+    int const         n,
+    int const         isOneBased,
+    int const         symmetric,
+    int const         nthreads
+) {
+
+    // ----- the T x n cursors may take at most the space of the CSC being built
+    int64_t const total = symmetric ? 2*nnz : nnz;
+    int T = nthreads;
+    if (T > nnz/65536 + 1)
+        T = nnz/65536 + 1;
+    if (n > 0 && T > total/(2*(int64_t) n) + 1)
+        T = total/(2*(int64_t) n) + 1;
+
+    int64_t *hist = (T > 1) ? (int64_t *) malloc((size_t) T * n * sizeof(int64_t)) : NULL;
+    if (hist == NULL){
+        if (symmetric)
+            coo2csc_symmetric(row, col, row_coo, col_coo, nnz, n, isOneBased);
+        else
+            coo2csc(row, col, row_coo, col_coo, nnz, n, isOneBased);
+        return;
+    }
+
+    int64_t block_sum[T];
+    pthread_t threads[T];
+    coo2csc_worker w[T];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, T);
+
+    for (int t = 0; t < T; t++){
+        w[t].id = t;
+        w[t].nthreads = T;
+        w[t].row = row;
+        w[t].col = col;
+        w[t].row_coo = row_coo;
+        w[t].col_coo = col_coo;
+        w[t].nnz = nnz;
+        w[t].n = n;
+        w[t].isOneBased = isOneBased;
+        w[t].symmetric = symmetric;
+        w[t].hist = hist;
+        w[t].block_sum = block_sum;
+        w[t].barrier = &barrier;
+    }
+
+    for (int t = 1; t < T; t++)
+        pthread_create(&threads[t], NULL, coo2csc_thread, (void *)(w+t));
+    coo2csc_thread((void *) w);
+    for (int t = 1; t < T; t++)
+        pthread_join(threads[t], NULL);
+
+    pthread_barrier_destroy(&barrier);
+    free(hist);
+}
+
+void coo2csc_parallel(
+    int       * const row,       /*!< CSC row start indices */
+    int64_t   * const col,       /*!< CSC column indices */
+    int const * const row_coo,   /*!< COO row indices */
+    int const * const col_coo,   /*!< COO column indices */
+    int64_t const     nnz,       /*!< Number of nonzero elements */
+    int const         n,         /*!< Number of rows/columns */
+    int const         isOneBased,/*!< Whether COO is 0- or 1-based */
+    int const         nthreads   /*!< Number of threads to use */
+) {
+    coo2csc_run(row, col, row_coo, col_coo, nnz, n, isOneBased, 0, nthreads);
+}
+
+void coo2csc_symmetric_parallel(
+    int       * const row,       /*!< CSC row start indices */
+    int64_t   * const col,       /*!< CSC column indices */
+    int const * const row_coo,   /*!< COO row indices */
+    int const * const col_coo,   /*!< COO column indices */
+    int64_t const     nnz,       /*!< Number of nonzero elements */
+    int const         n,         /*!< Number of rows/columns */
+    int const         isOneBased,/*!< Whether COO is 0- or 1-based */
+    int const         nthreads   /*!< Number of threads to use */
+) {
+    coo2csc_run(row, col, row_coo, col_coo, nnz, n, isOneBased, 1, nthreads);
+}
+
+/* Columns up to this length are insertion sorted, longer ones radix sorted */
+#define INSERTION_SORT_MAX 64
+
+static void insertion_sort(int *a, int len){
+    for (int i = 1; i < len; i++){
+        int key = a[i];
+        int k = i - 1;
+        while (k >= 0 && a[k] > key){
+            a[k+1] = a[k];
+            k--;
+        }
+        a[k+1] = key;
+    }
+}
+
+/* LSD radix sort on bytes, skipping the bytes above the largest key */
+static void radix_sort(int *a, int *scratch, int64_t len, int n){
+    int *src = a, *dst = scratch;
+
+    for (int shift = 0; shift < 32 && (n-1) >> shift; shift += 8){
+        int64_t count[257] = {0};
+        for (int64_t i = 0; i < len; i++)
+            count[((src[i] >> shift) & 0xff) + 1]++;
+        for (int b = 0; b < 256; b++)
+            count[b+1] += count[b];
+        for (int64_t i = 0; i < len; i++)
+            dst[count[(src[i] >> shift) & 0xff]++] = src[i];
+
+        int *temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    if (src != a)
+        for (int64_t i = 0; i < len; i++)
+            a[i] = src[i];
+}
+
+static int is_sorted(int const *a, int64_t len){
+    for (int64_t i = 1; i < len; i++)
+        if (a[i-1] > a[i])
+            return 0;
+    return 1;
+}
+
+typedef struct {
+    int *row;
+    int64_t const *col;
+    int n;
+    int c_lo;                   /*!< First column of this thread */
+    int c_hi;                   /*!< One past the last column of this thread */
+    int sorted;                 /*!< Columns that had to be sorted, -1 if out of memory */
+} sort_worker;
+
+static void *sort_columns_thread(void *arg){
+    sort_worker *w = (sort_worker *)arg;
+    int64_t const *col = w->col;
+
+    int64_t longest = 0;
+    for (int c = w->c_lo; c < w->c_hi; c++)
+        if (col[c+1] - col[c] > longest)
+            longest = col[c+1] - col[c];
+    int *scratch = (longest > INSERTION_SORT_MAX) ? (int *) malloc(longest * sizeof(int)) : NULL;
+
+    w->sorted = 0;
+    for (int c = w->c_lo; c < w->c_hi; c++){
+        int *a = w->row + col[c];
+        int64_t len = col[c+1] - col[c];
+
+        if (is_sorted(a, len))
+            continue;
+        if (len <= INSERTION_SORT_MAX)
+            insertion_sort(a, len);
+        else if (scratch != NULL)
+            radix_sort(a, scratch, len, w->n);
+        else{
+            w->sorted = -1;
+            break;
+        }
+        w->sorted++;
+    }
+
+    free(scratch);
+    return NULL;
+}
+
+int csc_sort_columns(
+    int           * const row,   /*!< CSC row indices */
+    int64_t const * const col,   /*!< CSC column start indices */
+    int const         n,         /*!< Number of rows/columns */
+    int const         nthreads   /*!< Number of threads to use */
+) {
+
+    int T = (nthreads < 1) ? 1 : nthreads;
+    pthread_t threads[T];
+    sort_worker w[T];
+
+    // ----- give every thread about the same number of entries
+    int c = 0;
+    for (int t = 0; t < T; t++){
+        w[t].row = row;
+        w[t].col = col;
+        w[t].n = n;
+        w[t].c_lo = c;
+        int64_t target = col[n] * (t+1) / T;
+        while (c < n && (t == T-1 || col[c+1] <= target))
+            c++;
+        w[t].c_hi = c;
+    }
+
+    for (int t = 1; t < T; t++)
+        pthread_create(&threads[t], NULL, sort_columns_thread, (void *)(w+t));
+    sort_columns_thread((void *) w);
+    for (int t = 1; t < T; t++)
+        pthread_join(threads[t], NULL);
+
+    int sorted = 0;
+    for (int t = 0; t < T; t++){
+        if (w[t].sorted < 0)
+            return -1;
+        sorted += w[t].sorted;
+    }
+    return sorted;
+}
+
+int64_t csc_remove_duplicates(
+    int       * const row,       /*!< CSC row indices, sorted per column */
+    int64_t   * const col,       /*!< CSC column start indices */
+    int const         n,         /*!< Number of rows/columns */
+    int64_t   * const self_loops,/*!< Removed diagonal entries */
+    int64_t   * const duplicates /*!< Removed repeated entries */
+) {
+
+    int64_t dst = 0;
+    *self_loops = 0;
+    *duplicates = 0;
+
+    for (int c = 0; c < n; c++){
+        int64_t start = col[c], end = col[c+1];
+        col[c] = dst;
+
+        // ----- keep the first copy of every row index except c itself
+        for (int64_t k = start; k < end; k++){
+            if (row[k] == c)
+                (*self_loops)++;
+            else if (dst > col[c] && row[dst-1] == row[k])
+                (*duplicates)++;
+            else
+                row[dst++] = row[k];
+        }
+    }
+    col[n] = dst;
+
+    return dst;
+}
+
+int csc_is_symmetric(
+    int     const * const row,   /*!< CSC row indices, sorted per column */
+    int64_t const * const col,   /*!< CSC column start indices */
+    int const         n          /*!< Number of rows/columns */
+) {
+
+    for (int j = 0; j < n; j++){
+        for (int64_t k = col[j]; k < col[j+1]; k++){
+            int i = row[k];
+
+            // ----- binary search for j in column i
+            int64_t lo = col[i], hi = col[i+1];
+            while (lo < hi){
+                int64_t mid = lo + (hi - lo)/2;
+                if (row[mid] < j)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            if (lo == col[i+1] || row[lo] != j)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+int csc_build_graph(
+    mtx_coo const * const A,     /*!< 1-based COO entries and banner */
+    int           * * const row, /*!< Allocated CSC row indices */
+    int64_t       * * const col, /*!< Allocated CSC column start indices */
+    int const               nthreads,
+    csc_build_info * const  info
+) {
+
+    if (A->M != A->N)
+        return MM_NOT_SQUARE;
+
+    int const n = A->N;
+    int64_t const nnz = A->nnz;
+    int *csc_row;
+    int64_t *csc_col = (int64_t *) malloc(((size_t) n+1)*sizeof(int64_t));
+    if (csc_col == NULL)
+        return MM_OUT_OF_MEMORY;
+
+    info->mirrored = !mm_is_general(A->matcode);
+
+    for (;;){
+        int64_t entries = info->mirrored ? 2*nnz : nnz;
+        csc_row = (int *) malloc((size_t)(entries > 0 ? entries : 1)*sizeof(int));
+        if (csc_row == NULL){
+            free(csc_col);
+            return MM_OUT_OF_MEMORY;
+        }
+
+        if (info->mirrored)
+            coo2csc_symmetric_parallel(csc_row, csc_col, A->coo_row, A->coo_col,
+                                       nnz, n, 1, nthreads);
+        else
+            coo2csc_parallel(csc_row, csc_col, A->coo_row, A->coo_col,
+                             nnz, n, 1, nthreads);
+
+        if (csc_sort_columns(csc_row, csc_col, n, nthreads) < 0){
+            free(csc_row);
+            free(csc_col);
+            return MM_OUT_OF_MEMORY;
+        }
+        csc_remove_duplicates(csc_row, csc_col, n, &info->self_loops, &info->duplicates);
+
+        // ----- a general file that only lists one direction of some edges
+        if (info->mirrored || csc_is_symmetric(csc_row, csc_col, n))
+            break;
+
+        free(csc_row);
+        info->mirrored = 1;
+    }
+
+    // ----- give back the space of the removed entries
+    if (csc_col[n] > 0 && csc_col[n] < (info->mirrored ? 2*nnz : nnz)){
+        int *shrunk = (int *) realloc(csc_row, (size_t) csc_col[n]*sizeof(int));
+        if (shrunk != NULL)
+            csc_row = shrunk;
+    }
+
+    *row = csc_row;
+    *col = csc_col;
+    return 0;
+}
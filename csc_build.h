@@ -0,0 +1,132 @@
+/*
+** csc_build.h -- construction of the CSC adjacency from COO entries
+**
+** Row indices are 32-bit vertex ids, column start indices are 64-bit
+** offsets, so a graph may hold more than 2^31 entries while every
+** entry still costs 4 bytes.
+*/
+
+#ifndef CSC_BUILD_H
+#define CSC_BUILD_H
+
+#include <stdint.h>
+#include "mtx_loader.h"
+
+void coo2csc(
+    int       * const row,       /*!< CSC row start indices */
+    int64_t   * const col,       /*!< CSC column indices */
+    int const * const row_coo,   /*!< COO row indices */
+    int const * const col_coo,   /*!< COO column indices */
+    int64_t const     nnz,       /*!< Number of nonzero elements */
+    int const         n,         /*!< Number of rows/columns */
+    int const         isOneBased /*!< Whether COO is 0- or 1-based */
+);
+
+/*
+** Same result as coo2csc, computed by nthreads threads: per-thread
+** column histograms, a parallel prefix sum and a parallel scatter.
+** Every thread keeps its own write cursor per column, so the scatter
+** needs no atomics and rows keep their COO order inside each column.
+** The cursors take 8 bytes per thread and column, so fewer threads are
+** used when T*n*8 would exceed the size of the CSC; graphs with
+** fewer than two entries per column are converted serially.
+*/
+void coo2csc_parallel(
+    int       * const row,       /*!< CSC row start indices */
+    int64_t   * const col,       /*!< CSC column indices */
+    int const * const row_coo,   /*!< COO row indices */
+    int const * const col_coo,   /*!< COO column indices */
+    int64_t const     nnz,       /*!< Number of nonzero elements */
+    int const         n,         /*!< Number of rows/columns */
+    int const         isOneBased,/*!< Whether COO is 0- or 1-based */
+    int const         nthreads   /*!< Number of threads to use */
+);
+
+/*
+** Build the CSC of the symmetric matrix A + A' directly from the COO
+** entries of A: row must hold 2*nnz entries. The result is the same as
+** coo2csc on the entries [row_coo col_coo; col_coo row_coo], without
+** allocating them.
+*/
+void coo2csc_symmetric(
+    int       * const row,       /*!< CSC row start indices */
+    int64_t   * const col,       /*!< CSC column indices */
+    int const * const row_coo,   /*!< COO row indices */
+    int const * const col_coo,   /*!< COO column indices */
+    int64_t const     nnz,       /*!< Number of nonzero elements */
+    int const         n,         /*!< Number of rows/columns */
+    int const         isOneBased /*!< Whether COO is 0- or 1-based */
+);
+
+void coo2csc_symmetric_parallel(
+    int       * const row,       /*!< CSC row start indices */
+    int64_t   * const col,       /*!< CSC column indices */
+    int const * const row_coo,   /*!< COO row indices */
+    int const * const col_coo,   /*!< COO column indices */
+    int64_t const     nnz,       /*!< Number of nonzero elements */
+    int const         n,         /*!< Number of rows/columns */
+    int const         isOneBased,/*!< Whether COO is 0- or 1-based */
+    int const         nthreads   /*!< Number of threads to use */
+);
+
+/*
+** Sort the row indices of every column in place, using nthreads threads.
+** Columns that are already sorted are left untouched, short columns are
+** insertion sorted and long ones radix sorted. Returns the number of
+** columns that had to be sorted, or -1 when the scratch of a radix sort
+** could not be allocated; some columns are then left unsorted.
+*/
+int csc_sort_columns(
+    int           * const row,   /*!< CSC row indices */
+    int64_t const * const col,   /*!< CSC column start indices */
+    int const         n,         /*!< Number of rows/columns */
+    int const         nthreads   /*!< Number of threads to use */
+);
+
+/*
+** Remove the diagonal entries and the repeated row indices of every
+** sorted column in place, compacting row and updating col. The number
+** of removed self-loop and duplicate entries is stored in *self_loops
+** and *duplicates. Returns the new number of entries.
+*/
+int64_t csc_remove_duplicates(
+    int       * const row,       /*!< CSC row indices, sorted per column */
+    int64_t   * const col,       /*!< CSC column start indices */
+    int const         n,         /*!< Number of rows/columns */
+    int64_t   * const self_loops,/*!< Removed diagonal entries */
+    int64_t   * const duplicates /*!< Removed repeated entries */
+);
+
+/* Whether every entry (i,j) of the sorted CSC also has its (j,i) */
+int csc_is_symmetric(
+    int     const * const row,   /*!< CSC row indices, sorted per column */
+    int64_t const * const col,   /*!< CSC column start indices */
+    int const         n          /*!< Number of rows/columns */
+);
+
+typedef struct {
+    int mirrored;               /*!< Whether the entries had to be mirrored */
+    int64_t self_loops;         /*!< Removed diagonal entries */
+    int64_t duplicates;         /*!< Removed repeated entries */
+} csc_build_info;
+
+/*
+** Build the sorted, duplicate-free CSC of the undirected graph of A,
+** using nthreads threads. The banner decides how: symmetric and
+** skew-symmetric files only store one triangle, so every entry is
+** mirrored. General files are converted as they are and only mirrored
+** when the result turns out not to be symmetric, which saves half the
+** build work and memory on inputs that already list both directions.
+** Returns 0, MM_NOT_SQUARE when A is not a square matrix, or
+** MM_OUT_OF_MEMORY when the CSC does not fit; nothing is left allocated
+** on an error.
+*/
+int csc_build_graph(
+    mtx_coo const * const A,     /*!< 1-based COO entries and banner */
+    int           * * const row, /*!< Allocated CSC row indices */
+    int64_t       * * const col, /*!< Allocated CSC column start indices */
+    int const               nthreads,
+    csc_build_info * const  info
+);
+
+#endif
@@ -0,0 +1,155 @@
+/*
+** csc_cache.c -- binary cache of the finished CSC adjacency
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "csc_cache.h"
+
+/* FNV-1a over 32-bit words */
+static uint64_t checksum(uint64_t h, const int *data, size_t count){
+    for (size_t i=0; i<count; i++){
+        h ^= (uint32_t) data[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/* FNV-1a over 64-bit words, low half first */
+static uint64_t checksum64(uint64_t h, const int64_t *data, size_t count){
+    for (size_t i=0; i<count; i++){
+        h ^= (uint32_t) data[i];
+        h *= 0x100000001b3ULL;
+        h ^= (uint32_t)((uint64_t) data[i] >> 32);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static uint64_t csc_checksum(int N, int64_t nnz, const int *csc_row, const int64_t *csc_col){
+    uint64_t h = 0xcbf29ce484222325ULL;
+    h = checksum64(h, csc_col, (size_t) N+1);
+    h = checksum(h, csc_row, (size_t) nnz);
+    return h;
+}
+
+static char *cache_filename(const char *mtx_filename){
+    char *name = (char *) malloc(strlen(mtx_filename) + strlen(CSC_CACHE_SUFFIX) + 1);
+    strcpy(name, mtx_filename);
+    strcat(name, CSC_CACHE_SUFFIX);
+    return name;
+}
+
+int csc_cache_load(const char *mtx_filename, uint32_t flags, csc_cache *C){
+
+    struct stat source, st;
+    C->map = NULL;
+
+    if (stat(mtx_filename, &source) != 0)
+        return -1;
+
+    char *name = cache_filename(mtx_filename);
+    int fd = open(name, O_RDONLY);
+    free(name);
+    if (fd < 0)
+        return -1;
+
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(csc_cache_header)){
+        close(fd);
+        return -1;
+    }
+
+    size_t length = (size_t) st.st_size;
+    void *map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    const csc_cache_header *h = (const csc_cache_header *) map;
+    uint32_t const required = flags & ~(uint32_t) CSC_CACHE_VERIFY;
+
+    // ----- reject caches of another format or of an older input file
+    if (memcmp(h->magic, CSC_CACHE_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != CSC_CACHE_VERSION ||
+        (h->flags & required) != required ||
+        h->source_size != (int64_t) source.st_size ||
+        h->source_mtime != (int64_t) source.st_mtime ||
+        h->n < 0 || h->n > INT32_MAX || h->nnz < 0 ||
+        length != sizeof(csc_cache_header) + (size_t)(h->n + 1)*sizeof(int64_t)
+                                           + (size_t) h->nnz*sizeof(int)){
+        munmap(map, length);
+        return -1;
+    }
+
+    C->N = (int) h->n;
+    C->nnz = h->nnz;
+    C->flags = h->flags;
+    C->csc_col = (int64_t *)((char *) map + sizeof(csc_cache_header));
+    C->csc_row = (int *)(C->csc_col + C->N + 1);
+
+    // ----- the full checksum faults in the whole file, so it is optional
+    if (C->csc_col[0] != 0 || C->csc_col[C->N] != C->nnz ||
+        ((flags & CSC_CACHE_VERIFY) &&
+         csc_checksum(C->N, C->nnz, C->csc_row, C->csc_col) != h->checksum)){
+        munmap(map, length);
+        return -1;
+    }
+
+    C->map = map;
+    C->map_length = length;
+    return 0;
+}
+
+int csc_cache_write(const char *mtx_filename, uint32_t flags, int N, int64_t nnz,
+                    const int *csc_row, const int64_t *csc_col){
+
+    struct stat source;
+    if (stat(mtx_filename, &source) != 0)
+        return -1;
+
+    csc_cache_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CSC_CACHE_MAGIC, sizeof(h.magic));
+    h.version = CSC_CACHE_VERSION;
+    h.flags = flags;
+    h.n = N;
+    h.nnz = nnz;
+    h.source_size = source.st_size;
+    h.source_mtime = source.st_mtime;
+    h.checksum = csc_checksum(N, nnz, csc_row, csc_col);
+
+    // ----- write to a temporary file and rename it, so readers never see half a cache
+    char *name = cache_filename(mtx_filename);
+    char *tmp = (char *) malloc(strlen(name) + 5);
+    strcpy(tmp, name);
+    strcat(tmp, ".tmp");
+
+    FILE *f = fopen(tmp, "wb");
+    int ok = f != NULL &&
+             fwrite(&h, sizeof(h), 1, f) == 1 &&
+             fwrite(csc_col, sizeof(int64_t), (size_t) N+1, f) == (size_t) N+1 &&
+             fwrite(csc_row, sizeof(int), (size_t) nnz, f) == (size_t) nnz;
+    if (f != NULL && fclose(f) != 0)
+        ok = 0;
+
+    if (ok)
+        ok = rename(tmp, name) == 0;
+    if (!ok)
+        remove(tmp);
+
+    free(tmp);
+    free(name);
+    return ok ? 0 : -1;
+}
+
+void csc_cache_close(csc_cache *C){
+    if (C->map != NULL)
+        munmap(C->map, C->map_length);
+    C->map = NULL;
+}
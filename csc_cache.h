@@ -0,0 +1,72 @@
+/*
+** csc_cache.h -- binary cache of the finished CSC adjacency
+**
+** After the first run on a Matrix Market file the symmetrized and sorted
+** csc_col/csc_row arrays are written next to it as <file>.csc. Later
+** runs mmap that file instead of parsing and rebuilding the graph.
+** The header is followed by the N+1 64-bit csc_col offsets and then
+** by the nnz 32-bit csc_row indices.
+*/
+
+#ifndef CSC_CACHE_H
+#define CSC_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CSC_CACHE_MAGIC     "TRICSC\r\n"
+#define CSC_CACHE_VERSION   2     /*!< 2: 64-bit column start indices */
+#define CSC_CACHE_SUFFIX    ".csc"
+
+/* Properties of the cached arrays */
+#define CSC_CACHE_SORTED        0x1     /*!< Every column is sorted */
+#define CSC_CACHE_SYMMETRIZED   0x2     /*!< Both (i,j) and (j,i) are stored */
+#define CSC_CACHE_DEDUPLICATED  0x4     /*!< No self-loops or repeated entries */
+
+/* What the drivers count triangles on: a simple undirected graph */
+#define CSC_CACHE_GRAPH (CSC_CACHE_SORTED | CSC_CACHE_SYMMETRIZED | CSC_CACHE_DEDUPLICATED)
+
+/*
+** Load option, never stored: recompute the checksum of the arrays. This
+** reads every page of the file, so by default a load only checks the
+** header, the file length and the first and last column offsets.
+*/
+#define CSC_CACHE_VERIFY        0x100
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t flags;
+    int64_t  n;             /*!< Number of rows/columns */
+    int64_t  nnz;           /*!< Number of entries in csc_row */
+    int64_t  source_size;   /*!< Size of the Matrix Market file */
+    int64_t  source_mtime;  /*!< Modification time of the Matrix Market file */
+    uint64_t checksum;      /*!< Checksum of csc_col followed by csc_row */
+    uint64_t reserved;
+} csc_cache_header;
+
+typedef struct {
+    int N;
+    int64_t nnz;
+    int *csc_row;
+    int64_t *csc_col;
+    uint32_t flags;
+    void *map;              /*!< Mapping that backs csc_row/csc_col */
+    size_t map_length;
+} csc_cache;
+
+/*
+** Map the cache of the Matrix Market file mtx_filename. Returns 0 when
+** a cache exists, belongs to the current version of the file and has
+** all the required flags (and, with CSC_CACHE_VERIFY, passes the
+** checksum); -1 otherwise.
+*/
+int csc_cache_load(const char *mtx_filename, uint32_t flags, csc_cache *C);
+
+/* Write the cache of mtx_filename. Returns 0 on success, -1 otherwise. */
+int csc_cache_write(const char *mtx_filename, uint32_t flags, int N, int64_t nnz,
+                    const int *csc_row, const int64_t *csc_col);
+
+void csc_cache_close(csc_cache *C);
+
+#endif
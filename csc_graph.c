@@ -0,0 +1,122 @@
+/*
+** csc_graph.c -- the graph every driver counts triangles on
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "csc_graph.h"
+#include "mtx_loader.h"
+#include "csc_build.h"
+#include "csc_reorder.h"
+
+int csc_graph_verify = 0;
+
+/* Parse filename and build its CSC, then write the cache */
+static int build(const char *filename, int nthreads, csc_graph *G){
+    mtx_coo A;
+    csc_build_info info;
+    int ret_code;
+
+    if ((ret_code = mtx_load_coo_parallel(filename, &A, nthreads)) != 0){
+        if (ret_code == MM_UNSUPPORTED_TYPE){
+            printf("Sorry, this application does not support ");
+            printf("Market Market type: [%s]\n", mm_typecode_to_str(A.matcode));
+        }else
+            printf("Could not read Matrix Market file %s (error %d).\n", filename, ret_code);
+        return ret_code;
+    }
+
+    printf("Parsed %" PRId64 " entries (%.1f MB) in %.3f seconds: %.1f MB/s\n",
+           A.nnz, A.bytes/(1024.0*1024.0), A.parse_seconds, mtx_parse_mbps(&A));
+
+    if ((ret_code = csc_build_graph(&A, &G->csc_row, &G->csc_col, nthreads, &info)) != 0){
+        printf("Could not build the graph of %s (error %d).\n", filename, ret_code);
+        mtx_free_coo(&A);
+        return ret_code;
+    }
+    G->N = A.N;
+    mtx_free_coo(&A);
+
+    printf("Built CSC with %" PRId64 " entries (%s, removed %" PRId64 " self-loop and %" PRId64 " duplicate entries)\n",
+           G->csc_col[G->N], info.mirrored ? "mirrored" : "not mirrored",
+           info.self_loops, info.duplicates);
+
+    if (csc_cache_write(filename, CSC_CACHE_GRAPH,
+                        G->N, G->csc_col[G->N], G->csc_row, G->csc_col) != 0)
+        printf("Could not write %s%s\n", filename, CSC_CACHE_SUFFIX);
+    return 0;
+}
+
+int csc_graph_load(const char *filename, int nthreads, int order, csc_graph *G){
+
+    G->perm = NULL;
+
+    uint32_t flags = CSC_CACHE_GRAPH | (csc_graph_verify ? CSC_CACHE_VERIFY : 0);
+    if (csc_cache_load(filename, flags, &G->cache) == 0){
+        G->N = G->cache.N;
+        G->csc_row = G->cache.csc_row;
+        G->csc_col = G->cache.csc_col;
+        printf("Loaded %d columns and %" PRId64 " entries from %s%s\n",
+               G->N, G->cache.nnz, filename, CSC_CACHE_SUFFIX);
+    }else{
+        int ret_code = build(filename, nthreads, G);
+        if (ret_code != 0)
+            return ret_code;
+    }
+
+    if (order == CSC_REORDER_NONE || G->N == 0)
+        return 0;
+
+    // ----- relabel for locality; csc_graph_restore maps the counts back
+    struct timespec begin, end;
+    int *row;
+    int64_t *col;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    int *perm = csc_reorder_perm(G->csc_row, G->csc_col, G->N, order);
+    if (perm == NULL){
+        printf("Could not allocate the %s order.\n", csc_reorder_name(order));
+        csc_graph_free(G);
+        return -1;
+    }
+    if (csc_reorder_apply(G->csc_row, G->csc_col, G->N, perm, nthreads, &row, &col) != 0){
+        printf("Could not allocate the graph in %s order.\n", csc_reorder_name(order));
+        free(perm);
+        csc_graph_free(G);
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Reordered by %s in %.3f seconds\n", csc_reorder_name(order),
+           (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec)*1e-9);
+
+    csc_graph_free(G);
+    G->csc_row = row;
+    G->csc_col = col;
+    G->perm = perm;
+    return 0;
+}
+
+void csc_graph_restore(const csc_graph *G, int64_t *c3){
+    if (G->perm != NULL)
+        csc_reorder_restore(c3, G->perm, G->N);
+}
+
+size_t csc_graph_bytes(const csc_graph *G){
+    return ((size_t) G->N + 1)*sizeof(int64_t) + (size_t) G->csc_col[G->N]*sizeof(int);
+}
+
+void csc_graph_free(csc_graph *G){
+    if (G->cache.map != NULL)
+        csc_cache_close(&G->cache);
+    else{
+        free(G->csc_row);
+        free(G->csc_col);
+    }
+    free(G->perm);
+    G->csc_row = NULL;
+    G->csc_col = NULL;
+    G->perm = NULL;
+}
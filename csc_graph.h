@@ -0,0 +1,47 @@
+/*
+** csc_graph.h -- the graph every driver counts triangles on
+**
+** Maps the cache of a Matrix Market file when there is a valid one;
+** otherwise parses the file, builds the sorted, duplicate-free CSC and
+** writes the cache for the next run. The graph is then relabelled when
+** a vertex order is asked for. Progress goes to stdout in the format
+** the drivers have always printed.
+*/
+
+#ifndef CSC_GRAPH_H
+#define CSC_GRAPH_H
+
+#include <stdint.h>
+#include "csc_cache.h"
+
+typedef struct {
+    int N;
+    int *csc_row;           /*!< CSC row indices, sorted per column */
+    int64_t *csc_col;       /*!< CSC column start indices */
+    int *perm;              /*!< Old id of every new label, NULL if not reordered */
+    csc_cache cache;        /*!< Mapping that backs csc_row/csc_col, if any */
+} csc_graph;
+
+/*
+** Nonzero makes csc_graph_load recompute the checksum of the cache
+** (CSC_CACHE_VERIFY) and rebuild from the Matrix Market file when it
+** does not match; the drivers set it with -v.
+*/
+extern int csc_graph_verify;
+
+/*
+** Load the graph of filename with nthreads threads and relabel it by
+** order (a CSC_REORDER_*). Returns 0, or an MM_* error code (-1 when the
+** order could not be allocated) after printing what went wrong.
+*/
+int csc_graph_load(const char *filename, int nthreads, int order, csc_graph *G);
+
+/* Move per-vertex counts back to the vertex ids of the file */
+void csc_graph_restore(const csc_graph *G, int64_t *c3);
+
+/* Bytes of csc_row and csc_col */
+size_t csc_graph_bytes(const csc_graph *G);
+
+void csc_graph_free(csc_graph *G);
+
+#endif
@@ -0,0 +1,311 @@
+/*
+** csc_reorder.c -- vertex relabelling for locality
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "csc_reorder.h"
+#include "csc_build.h"
+
+static const char *order_names[] = { "none", "degree", "rcm", "gorder" };
+
+int csc_reorder_parse(const char *name){
+    for (int order = CSC_REORDER_NONE; order <= CSC_REORDER_GORDER; order++)
+        if (strcmp(name, order_names[order]) == 0)
+            return order;
+    return -1;
+}
+
+const char *csc_reorder_name(int order){
+    return order_names[order];
+}
+
+/* Vertices by decreasing degree, ties by id */
+static int *degree_order(int64_t const *col, int n){
+    int maxdeg = 0;
+    for (int v = 0; v < n; v++)
+        if (col[v+1] - col[v] > maxdeg)
+            maxdeg = (int)(col[v+1] - col[v]);
+
+    int *bucket = (int *) calloc((size_t) maxdeg + 2, sizeof(int));
+    int *perm = (int *) malloc((size_t) n * sizeof(int));
+    if (bucket == NULL || perm == NULL){
+        free(bucket);
+        free(perm);
+        return NULL;
+    }
+
+    for (int v = 0; v < n; v++)
+        bucket[maxdeg - (col[v+1] - col[v]) + 1]++;
+    for (int d = 0; d <= maxdeg; d++)
+        bucket[d+1] += bucket[d];
+    for (int v = 0; v < n; v++)
+        perm[bucket[maxdeg - (col[v+1] - col[v])]++] = v;
+
+    free(bucket);
+    return perm;
+}
+
+static int compare_keys(const void *a, const void *b){
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+static int *rcm_order(int const *row, int64_t const *col, int n){
+    int *start = degree_order(col, n);
+    int *order = (int *) malloc((size_t) n * sizeof(int));
+    char *visited = (char *) calloc((size_t) n, 1);
+    uint64_t *keys = NULL;
+    if (start != NULL && n > 0)
+        keys = (uint64_t *) malloc((size_t)(col[start[0]+1] - col[start[0]] + 1) * sizeof(uint64_t));
+    if (start == NULL || order == NULL || visited == NULL || (n > 0 && keys == NULL)){
+        free(start);
+        free(order);
+        free(visited);
+        free(keys);
+        return NULL;
+    }
+
+    // ----- breadth first from the lowest degree vertex left, neighbours by (degree, id)
+    int head = 0, tail = 0;
+    for (int s = n-1; s >= 0; s--){
+        if (visited[start[s]])
+            continue;
+        visited[start[s]] = 1;
+        order[tail++] = start[s];
+
+        while (head < tail){
+            int u = order[head++], count = 0;
+            for (int64_t k = col[u]; k < col[u+1]; k++){
+                int v = row[k];
+                if (!visited[v]){
+                    visited[v] = 1;
+                    keys[count++] = (uint64_t)(col[v+1] - col[v]) << 32 | (uint32_t) v;
+                }
+            }
+            qsort(keys, count, sizeof(uint64_t), compare_keys);
+            for (int k = 0; k < count; k++)
+                order[tail++] = (int)(uint32_t) keys[k];
+        }
+    }
+
+    // ----- reversed
+    for (int a = 0, b = n-1; a < b; a++, b--){
+        int t = order[a];
+        order[a] = order[b];
+        order[b] = t;
+    }
+
+    free(start);
+    free(visited);
+    free(keys);
+    return order;
+}
+
+/*
+** Unplaced vertices sit in doubly linked lists by score, so raising or
+** lowering a score and taking a best vertex are all O(1) (the bucket
+** queue Gorder calls a unit heap).
+*/
+typedef struct {
+    int *score;
+    int *next, *prev;
+    int *head;          /*!< First vertex of every score, -1 if none */
+    int top;            /*!< No score above this has vertices */
+    char *placed;
+} gorder_queue;
+
+static void queue_unlink(gorder_queue *q, int v){
+    if (q->prev[v] >= 0)
+        q->next[q->prev[v]] = q->next[v];
+    else
+        q->head[q->score[v]] = q->next[v];
+    if (q->next[v] >= 0)
+        q->prev[q->next[v]] = q->prev[v];
+}
+
+static void queue_link(gorder_queue *q, int v){
+    int s = q->score[v];
+    q->prev[v] = -1;
+    q->next[v] = q->head[s];
+    if (q->head[s] >= 0)
+        q->prev[q->head[s]] = v;
+    q->head[s] = v;
+    if (s > q->top)
+        q->top = s;
+}
+
+static inline void queue_add(gorder_queue *q, int v, int delta){
+    if (q->placed[v])
+        return;
+    queue_unlink(q, v);
+    q->score[v] += delta;
+    queue_link(q, v);
+}
+
+/*
+** Add delta to the score of every unplaced neighbour of u (the Gorder
+** neighbour score) and of every vertex sharing a neighbour x with u
+** (the sibling score). Shared neighbours above hub entries are skipped,
+** as in Gorder, since they would touch a large part of the graph.
+*/
+static void window_update(gorder_queue *q, int const *row, int64_t const *col,
+                          int u, int hub, int delta){
+    for (int64_t k = col[u]; k < col[u+1]; k++){
+        int x = row[k];
+        queue_add(q, x, delta);
+        if (col[x+1] - col[x] > hub)
+            continue;
+        for (int64_t l = col[x]; l < col[x+1]; l++)
+            if (row[l] != u)
+                queue_add(q, row[l], delta);
+    }
+}
+
+static int *gorder_order(int const *row, int64_t const *col, int n){
+    int *start = degree_order(col, n);
+    if (start == NULL)
+        return NULL;
+
+    int maxdeg = (n > 0) ? (int)(col[start[0]+1] - col[start[0]]) : 0;
+    int maxscore = CSC_REORDER_WINDOW * (maxdeg + 1);
+    int hub = 1;
+    while ((long) hub*hub < n)
+        hub++;
+
+    gorder_queue q;
+    q.score = (int *) calloc((size_t) n, sizeof(int));
+    q.next = (int *) malloc((size_t) n * sizeof(int));
+    q.prev = (int *) malloc((size_t) n * sizeof(int));
+    q.head = (int *) malloc(((size_t) maxscore + 1) * sizeof(int));
+    q.placed = (char *) calloc((size_t) n, 1);
+    q.top = 0;
+    int *order = (int *) malloc((size_t) n * sizeof(int));
+
+    if (q.score == NULL || q.next == NULL || q.prev == NULL || q.head == NULL ||
+        q.placed == NULL || order == NULL){
+        free(order);
+        order = NULL;
+    }else{
+        for (int s = 0; s <= maxscore; s++)
+            q.head[s] = -1;
+
+        // ----- score 0 lists the highest degree first, so every component starts at a hub
+        for (int r = n-1; r >= 0; r--)
+            queue_link(&q, start[r]);
+
+        for (int i = 0; i < n; i++){
+            while (q.top > 0 && q.head[q.top] < 0)
+                q.top--;
+            int v = q.head[q.top];
+            queue_unlink(&q, v);
+            q.placed[v] = 1;
+            order[i] = v;
+
+            window_update(&q, row, col, v, hub, +1);
+            if (i >= CSC_REORDER_WINDOW)
+                window_update(&q, row, col, order[i - CSC_REORDER_WINDOW], hub, -1);
+        }
+    }
+
+    free(start);
+    free(q.score);
+    free(q.next);
+    free(q.prev);
+    free(q.head);
+    free(q.placed);
+    return order;
+}
+
+int *csc_reorder_perm(
+    int     const * const csc_row,   /*!< CSC row indices */
+    int64_t const * const csc_col,   /*!< CSC column start indices */
+    int const             n,         /*!< Number of rows/columns */
+    int const             order      /*!< CSC_REORDER_* */
+) {
+    if (n <= 0)
+        return NULL;
+    switch (order){
+    case CSC_REORDER_DEGREE: return degree_order(csc_col, n);
+    case CSC_REORDER_RCM:    return rcm_order(csc_row, csc_col, n);
+    case CSC_REORDER_GORDER: return gorder_order(csc_row, csc_col, n);
+    }
+    return NULL;
+}
+
+int csc_reorder_apply(
+    int     const * const csc_row,   /*!< CSC row indices */
+    int64_t const * const csc_col,   /*!< CSC column start indices */
+    int const             n,         /*!< Number of rows/columns */
+    int     const * const perm,      /*!< Old id of every new label */
+    int const             nthreads,  /*!< Threads used to sort the columns */
+    int           * * const row,     /*!< Allocated CSC row indices */
+    int64_t       * * const col      /*!< Allocated CSC column start indices */
+) {
+
+    int *rank = (int *) malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    int64_t *new_col = (int64_t *) malloc(((size_t) n+1) * sizeof(int64_t));
+    if (rank == NULL || new_col == NULL){
+        free(rank);
+        free(new_col);
+        return -1;
+    }
+    for (int r = 0; r < n; r++)
+        rank[perm[r]] = r;
+
+    new_col[0] = 0;
+    for (int r = 0; r < n; r++)
+        new_col[r+1] = new_col[r] + (csc_col[perm[r]+1] - csc_col[perm[r]]);
+
+    int *new_row = (int *) malloc((size_t)(new_col[n] > 0 ? new_col[n] : 1) * sizeof(int));
+    if (new_row == NULL){
+        free(rank);
+        free(new_col);
+        return -1;
+    }
+    for (int r = 0; r < n; r++){
+        int64_t dst = new_col[r];
+        for (int64_t k = csc_col[perm[r]]; k < csc_col[perm[r]+1]; k++)
+            new_row[dst++] = rank[csc_row[k]];
+    }
+    free(rank);
+
+    if (csc_sort_columns(new_row, new_col, n, nthreads) < 0){
+        free(new_row);
+        free(new_col);
+        return -1;
+    }
+
+    *row = new_row;
+    *col = new_col;
+    return 0;
+}
+
+void csc_reorder_restore(int64_t *c3, const int *perm, int n){
+    int64_t *old = (int64_t *) malloc((size_t) n * sizeof(int64_t));
+    if (old == NULL){
+        // ----- no scratch: follow the cycles of perm in place, a moved count is stored as ~count
+        for (int s = 0; s < n; s++){
+            if (c3[s] < 0)
+                continue;
+            int64_t carry = c3[s];
+            for (int r = s; ; ){
+                int d = perm[r];
+                int64_t next = c3[d];
+                c3[d] = ~carry;
+                if (d == s)
+                    break;
+                carry = next;
+                r = d;
+            }
+        }
+        for (int r = 0; r < n; r++)
+            c3[r] = ~c3[r];
+        return;
+    }
+    for (int r = 0; r < n; r++)
+        old[perm[r]] = c3[r];
+    memcpy(c3, old, (size_t) n * sizeof(int64_t));
+    free(old);
+}
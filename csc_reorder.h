@@ -0,0 +1,64 @@
+/*
+** csc_reorder.h -- vertex relabelling for locality
+**
+** Vertex ids of SNAP and SuiteSparse graphs follow the crawl or the
+** source data, so the columns a kernel visits next to each other lie
+** anywhere in csc_row. A permutation computed here relabels the graph
+** before counting; the counts are mapped back to the ids of the file
+** afterwards.
+**
+**     degree  decreasing degree, so the hubs share the first columns
+**     rcm     reverse Cuthill-McKee: breadth first from a low degree
+**             vertex of every component, neighbours by increasing
+**             degree, reversed; keeps neighbours close in id
+**     gorder  greedy Gorder: the next vertex is the one with the most
+**             neighbours and shared neighbours among the last
+**             CSC_REORDER_WINDOW placed vertices
+*/
+
+#ifndef CSC_REORDER_H
+#define CSC_REORDER_H
+
+#include <stdint.h>
+
+enum { CSC_REORDER_NONE, CSC_REORDER_DEGREE, CSC_REORDER_RCM, CSC_REORDER_GORDER };
+
+#define CSC_REORDER_WINDOW 5    /*!< Placed vertices gorder compares against */
+
+/* CSC_REORDER_* called name, or -1 */
+int csc_reorder_parse(const char *name);
+
+const char *csc_reorder_name(int order);
+
+/*
+** New order of the vertices of a symmetric CSC: perm[r] is the old id
+** of the vertex relabelled r. Returns NULL for CSC_REORDER_NONE, for an
+** empty graph or when out of memory.
+*/
+int *csc_reorder_perm(
+    int     const * const csc_row,   /*!< CSC row indices */
+    int64_t const * const csc_col,   /*!< CSC column start indices */
+    int const             n,         /*!< Number of rows/columns */
+    int const             order      /*!< CSC_REORDER_* */
+);
+
+/*
+** Allocate the CSC of the relabelled graph: column r is old column
+** perm[r] with every row i replaced by its new label, sorted again.
+** Returns 0, or -1 with nothing allocated when out of memory.
+*/
+int csc_reorder_apply(
+    int     const * const csc_row,   /*!< CSC row indices */
+    int64_t const * const csc_col,   /*!< CSC column start indices */
+    int const             n,         /*!< Number of rows/columns */
+    int     const * const perm,      /*!< Old id of every new label */
+    int const             nthreads,  /*!< Threads used to sort the columns */
+    int           * * const row,     /*!< Allocated CSC row indices */
+    int64_t       * * const col      /*!< Allocated CSC column start indices */
+);
+
+/* Move per-vertex counts of the relabelled graph back to the old ids, in
+** place when no scratch array can be allocated (counts are never negative) */
+void csc_reorder_restore(int64_t *c3, const int *perm, int n);
+
+#endif
@@ -0,0 +1,256 @@
+/*
+** csc_varint.c -- CSC adjacency with gap-encoded row lists
+*/
+
+#include <limits.h>
+#include <stdlib.h>
+
+#include "csc_varint.h"
+#include "intersect.h"
+
+/* Bytes of the varint of value */
+static int varint_length(uint32_t value){
+    int length = 1;
+    while (value >= 0x80){
+        value >>= 7;
+        length++;
+    }
+    return length;
+}
+
+static uint8_t *varint_put(uint8_t *p, uint32_t value){
+    while (value >= 0x80){
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t) value;
+    return p;
+}
+
+/* Read one varint at p; one-byte gaps, the common case, take one branch */
+static inline const uint8_t *varint_get(const uint8_t *p, uint32_t *value){
+    uint32_t v = *p++;
+    if (v >= 0x80){
+        v &= 0x7f;
+        int shift = 7;
+        uint32_t byte;
+        do {
+            byte = *p++;
+            v |= (byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte >= 0x80);
+    }
+    *value = v;
+    return p;
+}
+
+int csc_varint_build(
+    int     const * const csc_row,   /*!< CSC row indices, sorted per column */
+    int64_t const * const csc_col,   /*!< CSC column start indices */
+    int const             n,         /*!< Number of rows/columns */
+    int const             nthreads,  /*!< Threads that call csc_varint_column */
+    csc_varint    * const V
+) {
+
+    V->n = n;
+    V->max_degree = 0;
+    V->col = (int64_t *) malloc(((size_t) n+1) * sizeof(int64_t));
+    V->bytes = NULL;
+    V->block = (int *) malloc(((size_t) n+1) * sizeof(int));
+    V->block_row = NULL;
+    V->block_byte = NULL;
+    V->scratch = NULL;
+    if (V->col == NULL || V->block == NULL){
+        csc_varint_free(V);
+        return -1;
+    }
+
+    // ----- encoded length and skip entries of every column, then start offsets
+    V->col[0] = 0;
+    V->block[0] = 0;
+    for (int j = 0; j < n; j++){
+        int64_t degree = csc_col[j+1] - csc_col[j];
+        int64_t blocks = V->block[j] + (degree > 0 ? (degree - 1)/CSC_VARINT_BLOCK : 0);
+        if (blocks > INT_MAX){
+            csc_varint_free(V);
+            return -1;
+        }
+        V->block[j+1] = (int) blocks;
+        int64_t length = 0;
+        int previous = 0;
+        for (int64_t k = csc_col[j]; k < csc_col[j+1]; k++){
+            length += varint_length((uint32_t)(csc_row[k] - previous));
+            previous = csc_row[k];
+        }
+        V->col[j+1] = V->col[j] + length;
+        if (csc_col[j+1] - csc_col[j] > V->max_degree)
+            V->max_degree = (int)(csc_col[j+1] - csc_col[j]);
+    }
+
+    // ----- the blocks of two threads never share a cache line
+    V->stride = ((int64_t) V->max_degree + 15) & ~(int64_t) 15;
+    if (V->stride == 0)
+        V->stride = 16;
+    V->bytes = (uint8_t *) malloc((size_t)(V->col[n] > 0 ? V->col[n] : 1));
+    V->block_row = (int *) malloc((size_t)(V->block[n] > 0 ? V->block[n] : 1) * sizeof(int));
+    V->block_byte = (int64_t *) malloc((size_t)(V->block[n] > 0 ? V->block[n] : 1) * sizeof(int64_t));
+    V->scratch = (int *) aligned_alloc(64, (size_t) nthreads * V->stride * sizeof(int));
+    if (V->bytes == NULL || V->block_row == NULL || V->block_byte == NULL || V->scratch == NULL){
+        csc_varint_free(V);
+        return -1;
+    }
+
+    for (int j = 0; j < n; j++){
+        uint8_t *p = V->bytes + V->col[j];
+        int b = V->block[j];
+        int previous = 0;
+        for (int64_t k = csc_col[j]; k < csc_col[j+1]; k++){
+            p = varint_put(p, (uint32_t)(csc_row[k] - previous));
+            previous = csc_row[k];
+            if (k > csc_col[j] && (k - csc_col[j]) % CSC_VARINT_BLOCK == 0){
+                V->block_row[b] = csc_row[k];
+                V->block_byte[b] = p - V->bytes;
+                b++;
+            }
+        }
+    }
+    return 0;
+}
+
+void csc_varint_free(csc_varint *V){
+    free(V->col);
+    free(V->bytes);
+    free(V->block);
+    free(V->block_row);
+    free(V->block_byte);
+    free(V->scratch);
+    V->col = NULL;
+    V->bytes = NULL;
+    V->block = NULL;
+    V->block_row = NULL;
+    V->block_byte = NULL;
+    V->scratch = NULL;
+}
+
+size_t csc_varint_bytes(const csc_varint *V){
+    return ((size_t) V->n + 1)*(sizeof(int64_t) + sizeof(int)) + (size_t) V->col[V->n] +
+           (size_t) V->block[V->n]*(sizeof(int) + sizeof(int64_t));
+}
+
+/* Last of the blocks [q, blocks) whose row is at most x; row[q] <= x */
+static inline int64_t gallop_blocks(const int *row, int64_t blocks, int64_t q, uint32_t x){
+
+    // ----- double the step while the block still starts at or before x
+    int64_t hi = q + 1, step = 1;
+    while (hi < blocks && (uint32_t) row[hi] <= x){
+        q = hi;
+        step <<= 1;
+        hi = q + step;
+    }
+    if (hi > blocks)
+        hi = blocks;
+
+    // ----- last position in [q, hi) with row <= x
+    while (hi - q > 1){
+        int64_t mid = q + (hi - q)/2;
+        if ((uint32_t) row[mid] <= x)
+            q = mid;
+        else
+            hi = mid;
+    }
+    return q;
+}
+
+/* First position from k on with b >= x; b[nb-1] >= x */
+static inline int gallop_rows(const int *b, int nb, int k, uint32_t x){
+
+    // ----- double the step until b[hi] >= x, everything before k is < x
+    int hi = k, step = 1;
+    while (hi < nb && (uint32_t) b[hi] < x){
+        k = hi + 1;
+        hi += step;
+        step <<= 1;
+    }
+    if (hi >= nb)
+        hi = nb - 1;
+
+    // ----- first position in [k, hi] with b >= x
+    while (k < hi){
+        int mid = k + (hi - k)/2;
+        if ((uint32_t) b[mid] < x)
+            k = mid + 1;
+        else
+            hi = mid;
+    }
+    return k;
+}
+
+int csc_varint_intersect(const csc_varint *V, int i, const int *b, int nb){
+    if (nb == 0)
+        return 0;
+
+    const uint8_t *a = V->bytes + V->col[i], *a_end = V->bytes + V->col[i+1];
+    const int *block_row = V->block_row + V->block[i];
+    const int64_t *block_byte = V->block_byte + V->block[i];
+    int64_t blocks = V->block[i+1] - V->block[i], q = 0;
+
+    // ----- skewed pairs gallop: over the blocks of a long i, or over a long b;
+    //       the bytes of i bound its entries from above
+    if (intersect_skew <= 0 || blocks * CSC_VARINT_BLOCK <= (int64_t) intersect_skew * nb)
+        blocks = 0;
+    int skip_rows = intersect_skew > 0 && (a_end - a) * intersect_skew < nb;
+
+    // ----- rows of a beyond the last row of b can never match
+    uint32_t last = (uint32_t) b[nb-1], x = 0, gap;
+    int k = 0, common = 0;
+    while (a < a_end){
+        int skipped = 0;
+        if (q < blocks && (uint32_t) block_row[q] <= (uint32_t) b[k]){
+            int64_t lo = gallop_blocks(block_row, blocks, q, (uint32_t) b[k]);
+            q = lo + 1;
+            if ((uint32_t) block_row[lo] > x){
+                x = (uint32_t) block_row[lo];
+                a = V->bytes + block_byte[lo];
+                skipped = 1;
+            }
+        }
+        if (!skipped){
+            a = varint_get(a, &gap);
+            x += gap;
+        }
+        if (x > last)
+            break;
+        if (skip_rows)
+            k = gallop_rows(b, nb, k, x);
+        else
+            while ((uint32_t) b[k] < x)
+                k++;
+        common += (uint32_t) b[k] == x;
+    }
+    return common;
+}
+
+int csc_varint_decode(const csc_varint *V, int j, int *rows){
+    const uint8_t *p = V->bytes + V->col[j], *end = V->bytes + V->col[j+1];
+    uint32_t row = 0, gap;
+    int count = 0;
+    while (p < end){
+        p = varint_get(p, &gap);
+        row += gap;
+        rows[count++] = (int) row;
+    }
+    return count;
+}
+
+long csc_varint_column(const csc_varint *V, int j, int thread){
+    int *colA = V->scratch + (size_t) thread * V->stride;
+    int nzrangeOfColA = csc_varint_decode(V, j, colA);
+
+    long c = 0;
+    for (int k = 0; k < nzrangeOfColA; k++){
+        int i = colA[k];
+        c += csc_varint_intersect(V, i, colA, nzrangeOfColA);
+    }
+
+    return c;
+}
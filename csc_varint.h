@@ -0,0 +1,76 @@
+/*
+** csc_varint.h -- CSC adjacency with gap-encoded row lists
+**
+** Every column keeps its sorted rows as the gaps between consecutive
+** rows (the first row as it is), each gap written as a varint: seven
+** bits per byte, low bits first, the high bit set on every byte but the
+** last. Neighbour lists of sparse graphs mostly have gaps below 128, so
+** an entry takes one byte instead of the four of csc_row.
+**
+** The kernel expands only the list of the column j it works on, once,
+** into the scratch of the calling thread, and merges the encoded list of
+** every neighbour i against it, decoding one gap at a time and stopping
+** past the last row of j. The neighbour lists, which make up nearly all
+** of the traffic, are never expanded.
+**
+** Every CSC_VARINT_BLOCK-th entry of a column is also kept in a skip
+** index, as its row and the byte offset of the gap that follows it. When
+** one list of a pair is more than intersect_skew times the other, the
+** kernel gallops: over the blocks of a long encoded list, decoding only
+** the blocks a row of j falls in, or over the decoded rows of a long j.
+** A hub no longer costs its whole list for every one of its neighbours;
+** the index adds 4 bytes per column and 12 per block.
+*/
+
+#ifndef CSC_VARINT_H
+#define CSC_VARINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Entries between two rows of the skip index */
+#define CSC_VARINT_BLOCK 128
+
+typedef struct {
+    int n;
+    int max_degree;     /*!< Entries in the longest column */
+    int64_t *col;       /*!< Byte offset of every column in bytes, n+1 entries */
+    uint8_t *bytes;     /*!< Encoded gaps of all columns */
+    int *block;         /*!< First skip entry of every column, n+1 entries */
+    int *block_row;     /*!< Row of every CSC_VARINT_BLOCK-th entry but the first */
+    int64_t *block_byte;/*!< Byte offset of the gap after that row */
+    int *scratch;       /*!< Decoded rows of the current column, one block per thread */
+    int64_t stride;     /*!< Entries between the blocks of two threads */
+} csc_varint;
+
+/*
+** Encode a CSC with sorted columns, with scratch for nthreads threads.
+** Returns 0, or -1 when out of memory.
+*/
+int csc_varint_build(
+    int     const * const csc_row,   /*!< CSC row indices, sorted per column */
+    int64_t const * const csc_col,   /*!< CSC column start indices */
+    int const             n,         /*!< Number of rows/columns */
+    int const             nthreads,  /*!< Threads that call csc_varint_column */
+    csc_varint    * const V
+);
+
+void csc_varint_free(csc_varint *V);
+
+/* Bytes of col, bytes and the skip index, without the scratch */
+size_t csc_varint_bytes(const csc_varint *V);
+
+/* Number of values the encoded column i shares with the nb sorted b */
+int csc_varint_intersect(const csc_varint *V, int i, const int *b, int nb);
+
+/* Decode column j into rows; returns its number of entries */
+int csc_varint_decode(const csc_varint *V, int j, int *rows);
+
+/*
+** Sum of |rows(i) & rows(j)| over the rows i of column j, the value the
+** masked kernel adds to c3[j]. thread, below the nthreads of the build,
+** picks the scratch; no two threads may pass the same one at once.
+*/
+long csc_varint_column(const csc_varint *V, int j, int thread);
+
+#endif
@@ -0,0 +1,360 @@
+/*
+** intersect.c -- size of the intersection of two sorted sets
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "intersect.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define INTERSECT_X86 1
+#endif
+
+intersect_fn intersect_merge = intersect_scalar;
+int intersect_skew = INTERSECT_SKEW_DEFAULT;
+int intersect_hub_degree = INTERSECT_HUB_DEFAULT;
+
+int intersect_scalar(const int *restrict a, int na, const int *restrict b, int nb){
+    int i = 0, j = 0, common = 0;
+    while (i < na && j < nb){
+        if (a[i] < b[j])
+            i++;
+        else if (a[i] > b[j])
+            j++;
+        else{
+            common++;
+            i++;
+            j++;
+        }
+    }
+    return common;
+}
+
+int intersect_galloping(const int *restrict a, int na, const int *restrict b, int nb){
+    int j = 0, common = 0;
+
+    for (int i = 0; i < na && j < nb; i++){
+        int x = a[i];
+
+        // ----- double the step until b[hi] >= x, everything before j is < x
+        int hi = j, step = 1;
+        while (hi < nb && b[hi] < x){
+            j = hi + 1;
+            hi += step;
+            step <<= 1;
+        }
+        if (hi >= nb)
+            hi = nb - 1;
+
+        // ----- first position in [j, hi] with b >= x
+        int lo = j;
+        while (lo < hi){
+            int mid = lo + (hi - lo)/2;
+            if (b[mid] < x)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        j = lo;
+
+        if (j < nb && b[j] == x){
+            common++;
+            j++;
+        }
+    }
+    return common;
+}
+
+/*
+** Per-thread call counters. Every thread gets its own cache line on its
+** first call and links it into a global list, so counting costs no
+** shared writes and the counters outlive the threads.
+*/
+typedef struct stats_block {
+    intersect_stats stats;
+    struct stats_block *next;
+    char pad[64 - sizeof(intersect_stats) - sizeof(void *)];
+} stats_block;
+
+static __thread stats_block *local_stats;
+static stats_block *all_stats;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static stats_block *thread_stats(void){
+    if (local_stats == NULL){
+        stats_block *block = (stats_block *) aligned_alloc(64, sizeof(stats_block));
+        memset(block, 0, sizeof(stats_block));
+        pthread_mutex_lock(&stats_lock);
+        block->next = all_stats;
+        all_stats = block;
+        pthread_mutex_unlock(&stats_lock);
+        local_stats = block;
+    }
+    return local_stats;
+}
+
+int intersect_count(const int *restrict a, int na, const int *restrict b, int nb){
+    if (na > nb)
+        return intersect_count(b, nb, a, na);
+    if (na == 0)
+        return 0;
+
+    stats_block *block = thread_stats();
+    if (intersect_skew > 0 && (long) na * intersect_skew < nb){
+        block->stats.galloping++;
+        return intersect_galloping(a, na, b, nb);
+    }
+    block->stats.merge++;
+    return intersect_merge(a, na, b, nb);
+}
+
+void intersect_get_stats(intersect_stats *stats){
+    memset(stats, 0, sizeof(intersect_stats));
+    pthread_mutex_lock(&stats_lock);
+    for (stats_block *block = all_stats; block != NULL; block = block->next){
+        stats->merge += block->stats.merge;
+        stats->galloping += block->stats.galloping;
+        stats->bitmap += block->stats.bitmap;
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/*
+** Scratch bitmaps live on a free list: a thread takes one, marks the rows
+** of a column, probes, clears only the words it set and eventually puts
+** it back, so a bitmap is allocated once per concurrently running user.
+*/
+struct intersect_bitmap {
+    uint64_t *bits;
+    int n;
+    struct intersect_bitmap *next;
+};
+
+static intersect_bitmap *spare_bitmaps;
+static pthread_mutex_t bitmap_lock = PTHREAD_MUTEX_INITIALIZER;
+
+intersect_bitmap *intersect_bitmap_acquire(int n){
+    pthread_mutex_lock(&bitmap_lock);
+    intersect_bitmap *marks = spare_bitmaps;
+    if (marks != NULL)
+        spare_bitmaps = marks->next;
+    pthread_mutex_unlock(&bitmap_lock);
+
+    if (marks != NULL && marks->n < n){
+        free(marks->bits);
+        free(marks);
+        marks = NULL;
+    }
+    if (marks == NULL){
+        marks = (intersect_bitmap *) malloc(sizeof(intersect_bitmap));
+        if (marks == NULL)
+            return NULL;
+        marks->bits = (uint64_t *) calloc(n/64 + 1, sizeof(uint64_t));
+        if (marks->bits == NULL){
+            free(marks);
+            return NULL;
+        }
+        marks->n = n;
+    }
+    return marks;
+}
+
+void intersect_bitmap_release(intersect_bitmap *marks){
+    pthread_mutex_lock(&bitmap_lock);
+    marks->next = spare_bitmaps;
+    spare_bitmaps = marks;
+    pthread_mutex_unlock(&bitmap_lock);
+}
+
+long intersect_bitmap_column(intersect_bitmap *marks,
+                             const int *csc_row, const int64_t *csc_col, int j){
+    int const *restrict colA = csc_row + csc_col[j];
+    int nzrangeOfColA = csc_col[j+1]-csc_col[j];
+    uint64_t *restrict bits = marks->bits;
+
+    for (int k = 0; k < nzrangeOfColA; k++)
+        bits[colA[k] >> 6] |= (uint64_t) 1 << (colA[k] & 63);
+
+    long common = 0;
+    for (int k = 0; k < nzrangeOfColA; k++){
+        int i = colA[k];
+        for (int64_t x = csc_col[i]; x < csc_col[i+1]; x++)
+            common += (bits[csc_row[x] >> 6] >> (csc_row[x] & 63)) & 1;
+    }
+
+    for (int k = 0; k < nzrangeOfColA; k++)
+        bits[colA[k] >> 6] = 0;
+
+    thread_stats()->stats.bitmap += nzrangeOfColA;
+    return common;
+}
+
+/* Merge the list of column j with the list of each of its rows */
+static long merge_column(const int *csc_row, const int64_t *csc_col, int j){
+    int const *restrict colA = csc_row + csc_col[j];
+    int nzrangeOfColA = csc_col[j+1]-csc_col[j];
+
+    long c = 0;
+    for (int64_t k = csc_col[j]; k < csc_col[j+1]; k++){
+        int i = csc_row[k];
+        c += intersect_count(csc_row + csc_col[i], csc_col[i+1]-csc_col[i],
+                             colA, nzrangeOfColA);
+    }
+    return c;
+}
+
+long intersect_hub_column(const int *csc_row, const int64_t *csc_col, int n, int j){
+    intersect_bitmap *marks = intersect_bitmap_acquire(n);
+    if (marks == NULL)
+        return merge_column(csc_row, csc_col, j);
+    long common = intersect_bitmap_column(marks, csc_row, csc_col, j);
+    intersect_bitmap_release(marks);
+    return common;
+}
+
+long intersect_masked_column(const int *csc_row, const int64_t *csc_col, int n, int j){
+
+    // ----- hub columns: mark their rows once, probe every neighbour list
+    if (intersect_hub_degree > 0 && csc_col[j+1]-csc_col[j] > intersect_hub_degree)
+        return intersect_hub_column(csc_row, csc_col, n, j);
+
+    return merge_column(csc_row, csc_col, j);
+}
+
+void intersect_free_scratch(void){
+    pthread_mutex_lock(&bitmap_lock);
+    while (spare_bitmaps != NULL){
+        intersect_bitmap *marks = spare_bitmaps;
+        spare_bitmaps = marks->next;
+        free(marks->bits);
+        free(marks);
+    }
+    pthread_mutex_unlock(&bitmap_lock);
+}
+
+#ifdef INTERSECT_X86
+
+/*
+** Compare a block of 8 values of a with all 8 rotations of a block of b,
+** count the lanes of a that matched and advance the block(s) with the
+** smaller last value. Values are unique, so a match is never counted
+** twice. The tails are merged by the scalar routine.
+*/
+__attribute__((target("avx2")))
+int intersect_avx2(const int *restrict a, int na, const int *restrict b, int nb){
+    int i = 0, j = 0, common = 0;
+
+    if (na >= 8 && nb >= 8){
+        // ----- independent rotations, so the permutes do not form a chain
+        __m256i rot[8];
+        const __m256i lanes = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+        for (int r = 1; r < 8; r++)
+            rot[r] = _mm256_and_si256(_mm256_add_epi32(lanes, _mm256_set1_epi32(r)),
+                                      _mm256_set1_epi32(7));
+
+        while (i + 8 <= na && j + 8 <= nb){
+            __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+            __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+
+            __m256i match = _mm256_cmpeq_epi32(va, vb);
+            for (int r = 1; r < 8; r++)
+                match = _mm256_or_si256(match, _mm256_cmpeq_epi32(va,
+                                        _mm256_permutevar8x32_epi32(vb, rot[r])));
+            common += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(match)));
+
+            int a_last = a[i+7], b_last = b[j+7];
+            if (a_last <= b_last)
+                i += 8;
+            if (b_last <= a_last)
+                j += 8;
+        }
+    }
+
+    return common + intersect_scalar(a + i, na - i, b + j, nb - j);
+}
+
+/* Same as intersect_avx2, on blocks of 16 */
+__attribute__((target("avx512f")))
+int intersect_avx512(const int *restrict a, int na, const int *restrict b, int nb){
+    int i = 0, j = 0, common = 0;
+
+    if (na >= 16 && nb >= 16){
+        __m512i rot[16];
+        const __m512i lanes = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8,
+                                               7, 6, 5, 4, 3, 2, 1, 0);
+        for (int r = 1; r < 16; r++)
+            rot[r] = _mm512_and_si512(_mm512_add_epi32(lanes, _mm512_set1_epi32(r)),
+                                      _mm512_set1_epi32(15));
+
+        while (i + 16 <= na && j + 16 <= nb){
+            __m512i va = _mm512_loadu_si512((const void *)(a + i));
+            __m512i vb = _mm512_loadu_si512((const void *)(b + j));
+
+            __mmask16 match = _mm512_cmpeq_epi32_mask(va, vb);
+            for (int r = 1; r < 16; r++)
+                match |= _mm512_cmpeq_epi32_mask(va, _mm512_permutexvar_epi32(rot[r], vb));
+            common += __builtin_popcount(match);
+
+            int a_last = a[i+15], b_last = b[j+15];
+            if (a_last <= b_last)
+                i += 16;
+            if (b_last <= a_last)
+                j += 16;
+        }
+    }
+
+    return common + intersect_avx2(a + i, na - i, b + j, nb - j);
+}
+
+/* Whether the routine called name exists and this CPU can run it */
+static int supported(const char *name){
+    if (strcmp(name, "scalar") == 0)
+        return 1;
+    if (strcmp(name, "avx2") == 0)
+        return __builtin_cpu_supports("avx2");
+    if (strcmp(name, "avx512") == 0)
+        return __builtin_cpu_supports("avx512f");
+    return 0;
+}
+
+const char *intersect_init(const char *name){
+    __builtin_cpu_init();
+
+    // ----- the 16-lane all-pairs compare measured slower than avx2, so
+    // ----- it is only used when asked for
+    if (name == NULL)
+        name = __builtin_cpu_supports("avx2") ? "avx2" : "scalar";
+    if (!supported(name))
+        return NULL;
+
+    if (strcmp(name, "avx512") == 0)
+        intersect_merge = intersect_avx512;
+    else if (strcmp(name, "avx2") == 0)
+        intersect_merge = intersect_avx2;
+    else
+        intersect_merge = intersect_scalar;
+    return name;
+}
+
+#else
+
+int intersect_avx2(const int *restrict a, int na, const int *restrict b, int nb){
+    return intersect_scalar(a, na, b, nb);
+}
+
+int intersect_avx512(const int *restrict a, int na, const int *restrict b, int nb){
+    return intersect_scalar(a, na, b, nb);
+}
+
+const char *intersect_init(const char *name){
+    if (name != NULL && strcmp(name, "scalar") != 0)
+        return NULL;
+    intersect_merge = intersect_scalar;
+    return "scalar";
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+** intersect.h -- size of the intersection of two sorted sets
+**
+** All routines take two strictly increasing lists of row indices, read
+** in place from csc_row, and return the number of values they have in
+** common. The SIMD versions
+** compare whole blocks of both lists against each other and are only
+** called when the CPU supports them. When one list is much longer than
+** the other, galloping search from the shorter list beats any merge.
+*/
+
+#ifndef INTERSECT_H
+#define INTERSECT_H
+
+#include <stdint.h>
+
+typedef int (*intersect_fn)(const int *restrict a, int na, const int *restrict b, int nb);
+
+int intersect_scalar(const int *restrict a, int na, const int *restrict b, int nb);
+int intersect_avx2(const int *restrict a, int na, const int *restrict b, int nb);
+int intersect_avx512(const int *restrict a, int na, const int *restrict b, int nb);
+
+/* Exponential then binary search in b for every value of a; na <= nb */
+int intersect_galloping(const int *restrict a, int na, const int *restrict b, int nb);
+
+/* The merge routine intersect_count uses, set by intersect_init */
+extern intersect_fn intersect_merge;
+
+/*
+** Set intersect_merge to the routine called name ("scalar", "avx2" or
+** "avx512"), or to the fastest one the CPU supports when name is NULL.
+** Returns the name of the routine, or NULL if the CPU cannot run it.
+*/
+const char *intersect_init(const char *name);
+
+/*
+** Length ratio above which intersect_count gallops from the shorter list
+** instead of merging; 0 always merges.
+*/
+#define INTERSECT_SKEW_DEFAULT 32
+extern int intersect_skew;
+
+/* What the kernels call: intersect_merge or intersect_galloping */
+int intersect_count(const int *restrict a, int na, const int *restrict b, int nb);
+
+/*
+** Columns with more entries than this are intersected through a bitmap
+** of their rows instead of merged; 0 never uses the bitmap.
+*/
+#define INTERSECT_HUB_DEFAULT 1024
+extern int intersect_hub_degree;
+
+/*
+** Scratch bitmap of n bits for intersect_bitmap_column. Released bitmaps
+** are pooled and handed out again, so a thread that acquires one for a
+** column, or once for all of its columns, never reallocates it.
+** Acquire returns NULL when the memory is not available.
+*/
+typedef struct intersect_bitmap intersect_bitmap;
+
+intersect_bitmap *intersect_bitmap_acquire(int n);
+void intersect_bitmap_release(intersect_bitmap *marks);
+
+/*
+** Sum of |rows(i) & rows(j)| over the rows i of column j: the rows of j
+** are marked once in marks, every column i is probed against them and
+** only the touched words are cleared again. Each entry costs O(deg(i))
+** instead of the O(deg(i) + deg(j)) of a merge.
+*/
+long intersect_bitmap_column(intersect_bitmap *marks,
+                             const int *csc_row, const int64_t *csc_col, int j);
+
+/* intersect_bitmap_column on a pooled bitmap, for hub columns; merges without one */
+long intersect_hub_column(const int *csc_row, const int64_t *csc_col, int n, int j);
+
+/*
+** The masked kernel on column j, what every driver adds to c3[j]: the
+** same sum as intersect_bitmap_column, from intersect_count on every
+** pair of lists, or from intersect_hub_column when j has more than
+** intersect_hub_degree rows.
+*/
+long intersect_masked_column(const int *csc_row, const int64_t *csc_col, int n, int j);
+
+/* Free the pooled scratch bitmaps */
+void intersect_free_scratch(void);
+
+typedef struct {
+    long merge;         /*!< Calls of intersect_count that merged */
+    long galloping;     /*!< Calls of intersect_count that galloped */
+    long bitmap;        /*!< Intersections done against a bitmap */
+} intersect_stats;
+
+/* Totals over all threads since the start of the run */
+void intersect_get_stats(intersect_stats *stats);
+
+#endif
@@ -0,0 +1,287 @@
+/*
+** mtx_loader.c -- bulk Matrix Market coordinate loader
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mtx_loader.h"
+
+static double elapsed(struct timespec start, struct timespec stop){
+    return (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec)*1e-9;
+}
+
+/*
+** Skip blanks and line breaks, then read one unsigned decimal integer.
+** Values above INT_MAX come back as -1, which no index range accepts.
+*/
+static const char *parse_int(const char *p, const char *end, int *out){
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        p++;
+    if (p == end || *p < '0' || *p > '9')
+        return NULL;
+
+    int value = 0;
+    while (p < end && *p >= '0' && *p <= '9'){
+        int digit = *p - '0';
+        if (value >= 0)
+            value = (value > (INT_MAX - digit)/10) ? -1 : value*10 + digit;
+        p++;
+    }
+    *out = value;
+    return p;
+}
+
+/* The size line of mm_read_mtx_crd_size, with a 64-bit entry count */
+static int read_size_line(FILE *f, int *M, int *N, int64_t *nnz){
+    char line[MM_MAX_LINE_LENGTH];
+
+    *M = *N = 0;
+    *nnz = 0;
+    do {
+        if (fgets(line, MM_MAX_LINE_LENGTH, f) == NULL)
+            return MM_PREMATURE_EOF;
+    } while (line[0] == '%');
+
+    if (sscanf(line, "%d %d %" SCNd64, M, N, nnz) != 3 ||
+        *M < 0 || *N < 0 || *nnz < 0)
+        return MM_PREMATURE_EOF;
+    return 0;
+}
+
+/* Parse nnz "row col [value]" lines from [p, end), rows in 1..M and columns in 1..N */
+static int parse_entries(const char *p, const char *end,
+                         int *coo_row, int *coo_col, int64_t nnz, int M, int N){
+    for (int64_t i=0; i<nnz; i++){
+        if ((p = parse_int(p, end, &coo_row[i])) == NULL)
+            return MM_PREMATURE_EOF;
+        if ((p = parse_int(p, end, &coo_col[i])) == NULL)
+            return MM_PREMATURE_EOF;
+        if (coo_row[i] < 1 || coo_row[i] > M || coo_col[i] < 1 || coo_col[i] > N)
+            return MM_INDEX_OUT_OF_RANGE;
+
+        // ----- the value column (if any) is not needed for the pattern
+        while (p < end && *p != '\n')
+            p++;
+    }
+    return 0;
+}
+
+/* Number of non-blank lines in [p, end) */
+static int64_t count_entries(const char *p, const char *end){
+    int64_t count = 0;
+    while (p < end){
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+            p++;
+        if (p < end && *p >= '0' && *p <= '9')
+            count++;
+        while (p < end && *p != '\n')
+            p++;
+        p++;
+    }
+    return count;
+}
+
+/*
+** Every thread owns a newline-aligned byte range of the coordinate
+** section. The first pass counts the entries of each range, a prefix
+** sum turns the counts into offsets, and the second pass parses each
+** range into its own disjoint slice of coo_row/coo_col.
+*/
+typedef struct {
+    const char *begin;
+    const char *end;
+    int *coo_row;
+    int *coo_col;
+    int M, N;       /*!< Size line, bounds of the indices */
+    int64_t count;  /*!< Entries in [begin, end), then entries to parse */
+    int64_t offset; /*!< Position of the first entry in the COO arrays */
+    int ret_code;
+} parse_chunk;
+
+static void *count_chunk(void *arg){
+    parse_chunk *c = (parse_chunk *)arg;
+    c->count = count_entries(c->begin, c->end);
+    return NULL;
+}
+
+static void *parse_chunk_entries(void *arg){
+    parse_chunk *c = (parse_chunk *)arg;
+    c->ret_code = parse_entries(c->begin, c->end,
+                                c->coo_row + c->offset, c->coo_col + c->offset,
+                                c->count, c->M, c->N);
+    return NULL;
+}
+
+static void run_chunks(void *(*fn)(void *), parse_chunk *chunks, int nthreads){
+    pthread_t threads[nthreads];
+
+    for (int t=1; t<nthreads; t++)
+        pthread_create(&threads[t], NULL, fn, (void *)(chunks+t));
+    fn((void *)chunks);
+    for (int t=1; t<nthreads; t++)
+        pthread_join(threads[t], NULL);
+}
+
+static int parse_parallel(const char *begin, const char *end,
+                          int *coo_row, int *coo_col, int64_t nnz, int M, int N,
+                          int nthreads){
+
+    size_t length = end - begin;
+    if (nthreads < 1)
+        nthreads = 1;
+    if ((size_t) nthreads > length/4096 + 1)
+        nthreads = length/4096 + 1;
+
+    if (nthreads == 1)
+        return parse_entries(begin, end, coo_row, coo_col, nnz, M, N);
+
+    parse_chunk chunks[nthreads];
+
+    // ----- split at the first line break after every nominal boundary
+    const char *p = begin;
+    for (int t=0; t<nthreads; t++){
+        chunks[t].begin = p;
+        if (t == nthreads-1){
+            p = end;
+        }else{
+            const char *q = begin + length*(t+1)/nthreads;
+            if (q < p)
+                q = p;
+            while (q < end && *q != '\n')
+                q++;
+            p = (q < end) ? q+1 : end;
+        }
+        chunks[t].end = p;
+        chunks[t].coo_row = coo_row;
+        chunks[t].coo_col = coo_col;
+        chunks[t].M = M;
+        chunks[t].N = N;
+        chunks[t].ret_code = 0;
+    }
+
+    run_chunks(count_chunk, chunks, nthreads);
+
+    // ----- cumulative sum, entries past nnz are ignored like in the serial path
+    int64_t total = 0;
+    for (int t=0; t<nthreads; t++){
+        chunks[t].offset = total;
+        if (chunks[t].count > nnz - total)
+            chunks[t].count = nnz - total;
+        total += chunks[t].count;
+    }
+    if (total < nnz)
+        return MM_PREMATURE_EOF;
+
+    run_chunks(parse_chunk_entries, chunks, nthreads);
+
+    for (int t=0; t<nthreads; t++)
+        if (chunks[t].ret_code != 0)
+            return chunks[t].ret_code;
+    return 0;
+}
+
+int mtx_load_coo(const char *filename, mtx_coo *A){
+    return mtx_load_coo_parallel(filename, A, 1);
+}
+
+int mtx_load_coo_parallel(const char *filename, mtx_coo *A, int nthreads){
+
+    FILE *f;
+    int ret_code;
+
+    A->coo_row = NULL;
+    A->coo_col = NULL;
+    A->bytes = 0;
+    A->parse_seconds = 0;
+
+    if ((f = fopen(filename, "r")) == NULL)
+        return MM_COULD_NOT_READ_FILE;
+
+    if ((ret_code = mm_read_banner(f, &A->matcode)) != 0){
+        fclose(f);
+        return ret_code;
+    }
+
+    if (!mm_is_coordinate(A->matcode) || mm_is_complex(A->matcode) ||
+        mm_is_hermitian(A->matcode)){
+        fclose(f);
+        return MM_UNSUPPORTED_TYPE;
+    }
+
+    if ((ret_code = read_size_line(f, &A->M, &A->N, &A->nnz)) != 0){
+        fclose(f);
+        return ret_code;
+    }
+
+    long offset = ftell(f);
+    fclose(f);
+
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0){
+        if (fd >= 0) close(fd);
+        return MM_COULD_NOT_READ_FILE;
+    }
+
+    size_t length = (size_t) st.st_size;
+    A->bytes = length - (size_t) offset;
+
+    A->coo_row = (int *) malloc((size_t) A->nnz * sizeof(int));
+    A->coo_col = (int *) malloc((size_t) A->nnz * sizeof(int));
+    if (A->nnz > 0 && (A->coo_row == NULL || A->coo_col == NULL)){
+        close(fd);
+        mtx_free_coo(A);
+        return MM_OUT_OF_MEMORY;
+    }
+
+    if (A->nnz == 0){
+        close(fd);
+        return 0;
+    }
+
+    char *map = (char *) mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED){
+        mtx_free_coo(A);
+        return MM_COULD_NOT_READ_FILE;
+    }
+    madvise(map, length, MADV_SEQUENTIAL);
+
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    ret_code = parse_parallel(map + offset, map + length,
+                              A->coo_row, A->coo_col, A->nnz, A->M, A->N, nthreads);
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    A->parse_seconds = elapsed(start, stop);
+
+    munmap(map, length);
+
+    if (ret_code != 0)
+        mtx_free_coo(A);
+
+    return ret_code;
+}
+
+void mtx_free_coo(mtx_coo *A){
+    free(A->coo_row);
+    free(A->coo_col);
+    A->coo_row = NULL;
+    A->coo_col = NULL;
+}
+
+double mtx_parse_mbps(const mtx_coo *A){
+    if (A->parse_seconds <= 0)
+        return 0;
+    return A->bytes / (1024.0*1024.0) / A->parse_seconds;
+}
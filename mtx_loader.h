@@ -0,0 +1,54 @@
+/*
+** mtx_loader.h -- bulk Matrix Market coordinate loader
+**
+** The banner is read with mmio, the coordinate section is memory-mapped
+** and parsed with a hand-rolled tokenizer instead of one fscanf call per
+** entry, optionally by several threads. The size line is read here too,
+** so the entry count may exceed the int range mmio is limited to.
+*/
+
+#ifndef MTX_LOADER_H
+#define MTX_LOADER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mmio.h"
+
+/* Error codes next to the MM_* ones of mmio.h */
+#define MM_INDEX_OUT_OF_RANGE   18  /*!< An entry lies outside the size line */
+#define MM_NOT_SQUARE           19  /*!< A graph needs as many rows as columns */
+#define MM_OUT_OF_MEMORY        20  /*!< The entries or the graph do not fit in memory */
+
+typedef struct {
+    MM_typecode matcode;
+    int M, N;
+    int64_t nnz;
+    int *coo_row;           /*!< 1-based row indices, as stored in the file */
+    int *coo_col;           /*!< 1-based column indices, as stored in the file */
+    size_t bytes;           /*!< Size of the parsed coordinate section */
+    double parse_seconds;   /*!< Wall time spent in the tokenizer */
+} mtx_coo;
+
+/*
+** Load the pattern of a sparse Matrix Market file. Values of real and
+** integer matrices are skipped. Returns 0 on success or one of the
+** MM_* error codes of mmio.h, or MM_INDEX_OUT_OF_RANGE for an entry
+** outside 1..M x 1..N; on MM_UNSUPPORTED_TYPE A->matcode holds the
+** banner that was rejected.
+*/
+int mtx_load_coo(const char *filename, mtx_coo *A);
+
+/*
+** Same as mtx_load_coo, but the coordinate section is split into
+** newline-aligned byte ranges that are parsed by nthreads threads.
+** The result is identical to the serial loader.
+*/
+int mtx_load_coo_parallel(const char *filename, mtx_coo *A, int nthreads);
+
+void mtx_free_coo(mtx_coo *A);
+
+/* Parse throughput of the last load in MB/s */
+double mtx_parse_mbps(const mtx_coo *A);
+
+#endif
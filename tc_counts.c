@@ -0,0 +1,34 @@
+/*
+** tc_counts.c -- per-vertex triangle counts
+*/
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "tc_counts.h"
+
+size_t tc_counts_bytes(int n){
+    return (size_t)(n > 0 ? n : 1) * sizeof(int64_t);
+}
+
+int64_t *tc_counts_alloc(int n){
+
+    // ----- fresh anonymous pages: none is placed before its first write
+    void *map = mmap(NULL, tc_counts_bytes(n), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED)
+        return NULL;
+    return (int64_t *) map;
+}
+
+void tc_counts_free(int64_t *c3, int n){
+    if (c3 != NULL)
+        munmap(c3, tc_counts_bytes(n));
+}
+
+size_t tc_peak_rss(void){
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return (size_t) usage.ru_maxrss * 1024;
+}
@@ -0,0 +1,29 @@
+/*
+** tc_counts.h -- per-vertex triangle counts
+**
+** The counts live on the heap, not in a stack VLA, and are 64-bit:
+** a hub's triangles exceed 2^31 long before its degree does. The array
+** is mapped from fresh anonymous pages, which read as zero and are not
+** placed on a NUMA node until their first write; the parallel drivers
+** zero the block each thread counts inside their own parallel region,
+** so that first touch puts it on the node of that thread.
+*/
+
+#ifndef TC_COUNTS_H
+#define TC_COUNTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Zeroed, untouched counts for n vertices, or NULL if the memory is not available */
+int64_t *tc_counts_alloc(int n);
+
+void tc_counts_free(int64_t *c3, int n);
+
+/* Bytes taken by the counts of n vertices */
+size_t tc_counts_bytes(int n);
+
+/* Peak resident set size of the process so far, in bytes */
+size_t tc_peak_rss(void);
+
+#endif
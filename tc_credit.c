@@ -0,0 +1,91 @@
+/*
+** tc_credit.c -- per-vertex triangle credits from many threads
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "tc_credit.h"
+
+int tc_credit_init(tc_credit *C, int n, int nthreads, int mode, int64_t *c3){
+
+    if (mode == TC_CREDIT_AUTO)
+        mode = (n <= TC_CREDIT_PADDED_MAX) ? TC_CREDIT_ATOMIC : TC_CREDIT_BUFFERED;
+
+    C->mode = mode;
+    C->n = n;
+    C->nthreads = nthreads;
+    C->c3 = c3;
+    C->counters = NULL;
+    C->buffers = NULL;
+
+    if (mode == TC_CREDIT_ATOMIC){
+        C->counters = (tc_credit_counter *) aligned_alloc(64, (size_t)(n > 0 ? n : 1) * sizeof(tc_credit_counter));
+        if (C->counters == NULL)
+            return -1;
+        for (int v = 0; v < n; v++)
+            atomic_init(&C->counters[v].value, 0);
+    }else{
+        C->buffers = (tc_credit_buffer *) aligned_alloc(64, nthreads * sizeof(tc_credit_buffer));
+        if (C->buffers == NULL)
+            return -1;
+        for (int t = 0; t < nthreads; t++)
+            C->buffers[t].slots = NULL;
+        for (int t = 0; t < nthreads; t++){
+            C->buffers[t].slots = (tc_credit_slot *) malloc(TC_CREDIT_SLOTS * sizeof(tc_credit_slot));
+            if (C->buffers[t].slots == NULL){
+                tc_credit_free(C);
+                return -1;
+            }
+            // ----- every byte 0xff makes every vertex -1
+            memset(C->buffers[t].slots, 0xff, TC_CREDIT_SLOTS * sizeof(tc_credit_slot));
+        }
+    }
+    return 0;
+}
+
+/* Add every used slot of b to c3 and free it; atomic while other threads run */
+static void merge(tc_credit_buffer *b, int64_t *c3, int atomic){
+    for (int s = 0; s < TC_CREDIT_SLOTS; s++){
+        int v = b->slots[s].vertex;
+        if (v < 0)
+            continue;
+        if (atomic)
+            __atomic_fetch_add(&c3[v], b->slots[s].amount, __ATOMIC_RELAXED);
+        else
+            c3[v] += b->slots[s].amount;
+        b->slots[s].vertex = -1;
+    }
+}
+
+void tc_credit_flush(tc_credit *C, int thread){
+    // ----- c3 itself is plain int64_t, the adds only need to be atomic
+    merge(&C->buffers[thread], C->c3, 1);
+}
+
+void tc_credit_finish(tc_credit *C){
+    if (C->mode == TC_CREDIT_ATOMIC){
+        for (int v = 0; v < C->n; v++){
+            C->c3[v] += atomic_load_explicit(&C->counters[v].value, memory_order_relaxed);
+            atomic_store_explicit(&C->counters[v].value, 0, memory_order_relaxed);
+        }
+    }else{
+        // ----- the threads have joined, nothing else writes to c3
+        for (int t = 0; t < C->nthreads; t++)
+            merge(&C->buffers[t], C->c3, 0);
+    }
+}
+
+void tc_credit_free(tc_credit *C){
+    if (C->buffers != NULL)
+        for (int t = 0; t < C->nthreads; t++)
+            free(C->buffers[t].slots);
+    free(C->buffers);
+    free(C->counters);
+    C->buffers = NULL;
+    C->counters = NULL;
+}
+
+const char *tc_credit_name(const tc_credit *C){
+    return C->mode == TC_CREDIT_ATOMIC ? "padded atomic counters" : "per-thread tables";
+}
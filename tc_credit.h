@@ -0,0 +1,83 @@
+/*
+** tc_credit.h -- per-vertex triangle credits from many threads
+**
+** Enumerating kernels credit every triangle to all three of its
+** corners, so any thread may add to any c3 entry. Small graphs get one
+** atomic counter per vertex, each on its own cache line; on large
+** graphs that would cost 64 bytes per vertex, so every thread instead
+** sums its credits in a small table of its own, vertex v in slot v
+** modulo the table, so that repeated credits to a corner that stays in
+** its slot, a hub above all, cost one add. A vertex that takes over an
+** occupied slot adds the sum it finds there to c3 with one atomic add;
+** what the tables still hold is merged after the threads have joined.
+*/
+
+#ifndef TC_CREDIT_H
+#define TC_CREDIT_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define TC_CREDIT_PADDED_MAX    (1 << 20)   /*!< Most vertices given padded counters (64 MB) */
+#define TC_CREDIT_SLOTS_LOG     12          /*!< Slots of every per-thread table, log2 (64 kB) */
+#define TC_CREDIT_SLOTS         (1 << TC_CREDIT_SLOTS_LOG)
+
+enum { TC_CREDIT_AUTO, TC_CREDIT_ATOMIC, TC_CREDIT_BUFFERED };
+
+typedef struct {
+    _Atomic int64_t value;
+} __attribute__((aligned(64))) tc_credit_counter;
+
+typedef struct {
+    int vertex;         /*!< -1 when the slot is free */
+    int64_t amount;
+} tc_credit_slot;
+
+typedef struct {
+    tc_credit_slot *slots;  /*!< TC_CREDIT_SLOTS, vertex v sums in slot v modulo that */
+} __attribute__((aligned(64))) tc_credit_buffer;
+
+typedef struct {
+    int mode;                       /*!< TC_CREDIT_ATOMIC or TC_CREDIT_BUFFERED */
+    int n;
+    int nthreads;
+    int64_t *c3;                    /*!< Where the credits end up */
+    tc_credit_counter *counters;    /*!< TC_CREDIT_ATOMIC: one per vertex */
+    tc_credit_buffer *buffers;      /*!< TC_CREDIT_BUFFERED: one per thread */
+} tc_credit;
+
+/*
+** Credit c3[0..n) from threads 0..nthreads-1. TC_CREDIT_AUTO picks
+** padded atomic counters up to TC_CREDIT_PADDED_MAX vertices and
+** per-thread tables above that. Returns 0, or -1 when out of memory.
+*/
+int tc_credit_init(tc_credit *C, int n, int nthreads, int mode, int64_t *c3);
+
+/* Add the table of one thread to c3 with atomic adds and empty it */
+void tc_credit_flush(tc_credit *C, int thread);
+
+/* Add all credits still held by C to c3; call once every thread is done */
+void tc_credit_finish(tc_credit *C);
+
+void tc_credit_free(tc_credit *C);
+
+const char *tc_credit_name(const tc_credit *C);
+
+static inline void tc_credit_add(tc_credit *C, int thread, int vertex, int64_t amount){
+    if (C->mode == TC_CREDIT_ATOMIC){
+        atomic_fetch_add_explicit(&C->counters[vertex].value, amount, memory_order_relaxed);
+        return;
+    }
+
+    // ----- one slot per vertex modulo the table; another vertex evicts it with one atomic add
+    tc_credit_slot *s = &C->buffers[thread].slots[vertex & (TC_CREDIT_SLOTS - 1)];
+    if (s->vertex != vertex){
+        if (s->vertex >= 0)
+            __atomic_fetch_add(&C->c3[s->vertex], s->amount, __ATOMIC_RELAXED);
+        s->vertex = vertex;
+        s->amount = 0;
+    }
+    s->amount += amount;
+}
+
+#endif
@@ -0,0 +1,162 @@
+/*
+** tc_dag.c -- triangle counting on the degree-ordered DAG
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "tc_dag.h"
+
+int tc_dag_width_fit(int n, int64_t edges){
+    if (edges > UINT32_MAX)
+        return TC_DAG_WIDTH_32_64;
+    if (n <= UINT16_MAX + 1)
+        return TC_DAG_WIDTH_16_32;
+    return TC_DAG_WIDTH_32_32;
+}
+
+const char *tc_dag_width_name(int width){
+    switch (width){
+    case TC_DAG_WIDTH_16_32: return "16-bit ranks, 32-bit offsets";
+    case TC_DAG_WIDTH_32_32: return "32-bit ranks, 32-bit offsets";
+    case TC_DAG_WIDTH_32_64: return "32-bit ranks, 64-bit offsets";
+    }
+    return "auto";
+}
+
+size_t tc_dag_bytes(const tc_dag *D){
+    size_t ranks = (D->width == TC_DAG_WIDTH_16_32) ? sizeof(uint16_t) : sizeof(uint32_t);
+    size_t offsets = (D->width == TC_DAG_WIDTH_32_64) ? sizeof(int64_t) : sizeof(uint32_t);
+    int64_t edges = (D->width == TC_DAG_WIDTH_32_64) ? ((int64_t *) D->ptr)[D->n] :
+                                                       ((uint32_t *) D->ptr)[D->n];
+    return ((size_t) D->n + 1)*offsets + (size_t) edges*ranks;
+}
+
+int tc_dag_build(
+    int     const * const csc_row,   /*!< CSC row indices */
+    int64_t const * const csc_col,   /*!< CSC column start indices */
+    int const         n,         /*!< Number of rows/columns */
+    tc_dag    * const D
+) {
+    return tc_dag_build_width(csc_row, csc_col, n, TC_DAG_WIDTH_AUTO, D);
+}
+
+static int fill_16_32(int const *csc_row, int64_t const *csc_col, int n,
+                      int const *rank, int const *out, tc_dag *D);
+static int fill_32_32(int const *csc_row, int64_t const *csc_col, int n,
+                      int const *rank, int const *out, tc_dag *D);
+static int fill_32_64(int const *csc_row, int64_t const *csc_col, int n,
+                      int const *rank, int const *out, tc_dag *D);
+
+int tc_dag_build_width(
+    int     const * const csc_row,   /*!< CSC row indices */
+    int64_t const * const csc_col,   /*!< CSC column start indices */
+    int const         n,         /*!< Number of rows/columns */
+    int const         width,     /*!< TC_DAG_WIDTH_* */
+    tc_dag    * const D
+) {
+
+    int maxdeg = 0;
+    for (int v = 0; v < n; v++)
+        if (csc_col[v+1] - csc_col[v] > maxdeg)
+            maxdeg = csc_col[v+1] - csc_col[v];
+
+    // ----- counting sort of the vertices by degree, ties by id
+    int *bucket = (int *) calloc(maxdeg + 2, sizeof(int));
+    int *perm = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+    int *rank = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+    int *out = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+    if (bucket == NULL || perm == NULL || rank == NULL || out == NULL){
+        free(bucket);
+        free(perm);
+        free(rank);
+        free(out);
+        return -1;
+    }
+
+    for (int v = 0; v < n; v++)
+        bucket[csc_col[v+1] - csc_col[v] + 1]++;
+    for (int d = 0; d <= maxdeg; d++)
+        bucket[d+1] += bucket[d];
+
+    for (int v = 0; v < n; v++){
+        int r = bucket[csc_col[v+1] - csc_col[v]]++;
+        perm[r] = v;
+        rank[v] = r;
+    }
+    free(bucket);
+
+    // ----- out-degrees by rank; their sum picks the layout before anything is laid out
+    int64_t edges = 0;
+    for (int r = 0; r < n; r++){
+        int v = perm[r];
+        out[r] = 0;
+        for (int64_t k = csc_col[v]; k < csc_col[v+1]; k++)
+            out[r] += rank[csc_row[k]] > r;
+        edges += out[r];
+    }
+
+    D->n = n;
+    D->perm = perm;
+    D->width = tc_dag_width_fit(n, edges);
+    if (width != TC_DAG_WIDTH_AUTO && width > D->width)
+        D->width = width;
+
+    int ret;
+    switch (D->width){
+    case TC_DAG_WIDTH_16_32: ret = fill_16_32(csc_row, csc_col, n, rank, out, D); break;
+    case TC_DAG_WIDTH_32_32: ret = fill_32_32(csc_row, csc_col, n, rank, out, D); break;
+    default:                 ret = fill_32_64(csc_row, csc_col, n, rank, out, D); break;
+    }
+    free(out);
+    free(rank);
+    if (ret != 0)
+        free(perm);
+    return ret;
+}
+
+void tc_dag_free(tc_dag *D){
+    free(D->ptr);
+    free(D->adj);
+    free(D->perm);
+}
+
+#define TC_DAG_RANK     uint16_t
+#define TC_DAG_OFFSET   uint32_t
+#define TC_DAG_SUFFIX   16_32
+#include "tc_dag_kernel.h"
+
+#define TC_DAG_RANK     uint32_t
+#define TC_DAG_OFFSET   uint32_t
+#define TC_DAG_SUFFIX   32_32
+#include "tc_dag_kernel.h"
+
+#define TC_DAG_RANK     int
+#define TC_DAG_OFFSET   int64_t
+#define TC_DAG_SUFFIX   32_64
+#include "tc_dag_kernel.h"
+
+static inline long count_ranks(const tc_dag *D, int lo, int hi, int64_t *c3,
+                               tc_credit *C, int thread){
+    switch (D->width){
+    case TC_DAG_WIDTH_16_32: return count_ranks_16_32(D, lo, hi, c3, C, thread);
+    case TC_DAG_WIDTH_32_32: return count_ranks_32_32(D, lo, hi, c3, C, thread);
+    default:                 return count_ranks_32_64(D, lo, hi, c3, C, thread);
+    }
+}
+
+long tc_dag_count(const tc_dag *D, int lo, int hi, int64_t *c3){
+    return count_ranks(D, lo, hi, c3, NULL, 0);
+}
+
+long tc_dag_count_credit(const tc_dag *D, int lo, int hi, tc_credit *C, int thread){
+    return count_ranks(D, lo, hi, NULL, C, thread);
+}
+
+long *tc_dag_cost(const tc_dag *D){
+    switch (D->width){
+    case TC_DAG_WIDTH_16_32: return cost_16_32(D);
+    case TC_DAG_WIDTH_32_32: return cost_32_32(D);
+    default:                 return cost_32_64(D);
+    }
+}
@@ -0,0 +1,85 @@
+/*
+** tc_dag.h -- triangle counting on the degree-ordered DAG
+**
+** Vertices are relabelled by (degree, id) and every undirected edge is
+** kept only from its lower to its higher ranked end. Each triangle is
+** then found exactly once, from its lowest ranked corner, instead of
+** six times by the masked kernel.
+**
+** The loops are instantiated for several index widths (tc_dag_kernel.h)
+** and the build picks the narrowest that holds the graph: a DAG of at
+** most 65536 vertices keeps 2-byte ranks, one of fewer than 2^32 edges
+** keeps 4-byte start indices, so more of adj and ptr stays in cache.
+*/
+
+#ifndef TC_DAG_H
+#define TC_DAG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "tc_credit.h"
+
+/* Types of adj and ptr, narrowest first */
+enum {
+    TC_DAG_WIDTH_16_32,     /*!< uint16_t ranks, uint32_t start indices */
+    TC_DAG_WIDTH_32_32,     /*!< uint32_t ranks, uint32_t start indices */
+    TC_DAG_WIDTH_32_64,     /*!< int ranks, int64_t start indices */
+    TC_DAG_WIDTH_AUTO       /*!< The narrowest of the above that fits */
+};
+
+typedef struct {
+    int n;
+    int width;      /*!< TC_DAG_WIDTH_* layout of ptr and adj */
+    void *ptr;      /*!< Out-neighbour start indices, by rank */
+    void *adj;      /*!< Out-neighbour ranks, sorted per vertex */
+    int *perm;      /*!< Original id of every rank */
+} tc_dag;
+
+/*
+** Orient the symmetric, sorted, duplicate-free CSC by degree. Returns 0,
+** or -1 with nothing allocated when out of memory.
+*/
+int tc_dag_build(
+    int     const * const csc_row,   /*!< CSC row indices */
+    int64_t const * const csc_col,   /*!< CSC column start indices */
+    int const         n,         /*!< Number of rows/columns */
+    tc_dag    * const D
+);
+
+/*
+** Same as tc_dag_build with the layout given by width. A layout too
+** narrow for the graph is replaced by the narrowest one that fits;
+** D->width tells which one was used.
+*/
+int tc_dag_build_width(
+    int     const * const csc_row,   /*!< CSC row indices */
+    int64_t const * const csc_col,   /*!< CSC column start indices */
+    int const         n,         /*!< Number of rows/columns */
+    int const         width,     /*!< TC_DAG_WIDTH_* */
+    tc_dag    * const D
+);
+
+void tc_dag_free(tc_dag *D);
+
+/* Narrowest layout for n vertices and edges oriented edges */
+int tc_dag_width_fit(int n, int64_t edges);
+
+const char *tc_dag_width_name(int width);
+
+/* Bytes of ptr and adj */
+size_t tc_dag_bytes(const tc_dag *D);
+
+/* Prefix sum of the work per rank, as tc_sched_cost computes it for a CSC; NULL if out of memory */
+long *tc_dag_cost(const tc_dag *D);
+
+/*
+** Count the triangles whose lowest ranked corner lies in [lo, hi) and
+** credit each of them to all three corners of c3 (original ids).
+** Returns the number of triangles found.
+*/
+long tc_dag_count(const tc_dag *D, int lo, int hi, int64_t *c3);
+
+/* Same as tc_dag_count for one of several threads sharing the credits C */
+long tc_dag_count_credit(const tc_dag *D, int lo, int hi, tc_credit *C, int thread);
+
+#endif
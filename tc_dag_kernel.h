@@ -0,0 +1,136 @@
+/*
+** tc_dag_kernel.h -- DAG loops for one pair of index types
+**
+** Included by tc_dag.c once per layout, with
+**     TC_DAG_RANK     type of the out-neighbour ranks in adj
+**     TC_DAG_OFFSET   type of the start indices in ptr
+**     TC_DAG_SUFFIX   suffix of the generated function names
+** defined; they are undefined again at the end of this file. Only the
+** arrays are narrow, the loop indices stay 64-bit so that no access
+** pays for a zero extension.
+*/
+
+#define TC_DAG_PASTE2(name, suffix) name##_##suffix
+#define TC_DAG_PASTE(name, suffix) TC_DAG_PASTE2(name, suffix)
+#define TC_DAG_NAME(name) TC_DAG_PASTE(name, TC_DAG_SUFFIX)
+
+/*
+** Credits go straight to c3 when C is NULL and through C otherwise;
+** both callers pass a constant, so each gets its own copy of the loop.
+*/
+static inline __attribute__((always_inline))
+long TC_DAG_NAME(count_ranks)(const tc_dag *D, int lo, int hi, int64_t *c3,
+                              tc_credit *C, int thread){
+
+    TC_DAG_OFFSET const *ptr = (TC_DAG_OFFSET const *) D->ptr;
+    TC_DAG_RANK const *adj = (TC_DAG_RANK const *) D->adj;
+    int const *perm = D->perm;
+    long triangles = 0;
+
+    for (int u = lo; u < hi; u++){
+        long at_u = 0;
+        for (int64_t k = ptr[u]; k < (int64_t) ptr[u+1]; k++){
+            int v = adj[k];
+
+            // ----- third corners: out-neighbours of both u (after v) and v
+            int64_t a = k+1, a_end = ptr[u+1];
+            int64_t b = ptr[v], b_end = ptr[v+1];
+            int common = 0;
+            while (a < a_end && b < b_end){
+                if (adj[a] < adj[b])
+                    a++;
+                else if (adj[a] > adj[b])
+                    b++;
+                else{
+                    if (C == NULL)
+                        c3[perm[adj[a]]]++;
+                    else
+                        tc_credit_add(C, thread, perm[adj[a]], 1);
+                    common++;
+                    a++;
+                    b++;
+                }
+            }
+            if (common > 0){
+                if (C == NULL)
+                    c3[perm[v]] += common;
+                else
+                    tc_credit_add(C, thread, perm[v], common);
+            }
+            at_u += common;
+        }
+
+        // ----- every triangle found from u has u as a corner: one credit for all of them
+        if (at_u > 0){
+            if (C == NULL)
+                c3[perm[u]] += at_u;
+            else
+                tc_credit_add(C, thread, perm[u], at_u);
+        }
+        triangles += at_u;
+    }
+    return triangles;
+}
+
+/*
+** Lay out the DAG in these types directly: rank r is appended to the
+** list of every lower ranked neighbour, so with r increasing each list
+** comes out sorted and no wider copy of ptr or adj is ever held.
+*/
+static int TC_DAG_NAME(fill)(int const *csc_row, int64_t const *csc_col, int n,
+                             int const *rank, int const *out, tc_dag *D){
+    TC_DAG_OFFSET *ptr = (TC_DAG_OFFSET *) malloc(((size_t) n + 1) * sizeof(TC_DAG_OFFSET));
+    if (ptr == NULL)
+        return -1;
+    ptr[0] = 0;
+    for (int r = 0; r < n; r++)
+        ptr[r+1] = ptr[r] + out[r];
+    TC_DAG_RANK *adj = (TC_DAG_RANK *) malloc((size_t)(ptr[n] > 0 ? ptr[n] : 1) * sizeof(TC_DAG_RANK));
+    if (adj == NULL){
+        free(ptr);
+        return -1;
+    }
+
+    // ----- ptr[s] is the next free slot of s while filling, the start of s+1 after
+    for (int r = 0; r < n; r++){
+        int v = D->perm[r];
+        for (int64_t k = csc_col[v]; k < csc_col[v+1]; k++){
+            int s = rank[csc_row[k]];
+            if (s < r)
+                adj[ptr[s]++] = (TC_DAG_RANK) r;
+        }
+    }
+    for (int r = n; r > 0; r--)
+        ptr[r] = ptr[r-1];
+    ptr[0] = 0;
+
+    D->ptr = ptr;
+    D->adj = adj;
+    return 0;
+}
+
+/* tc_sched_cost of the DAG, without widening its arrays */
+static long *TC_DAG_NAME(cost)(const tc_dag *D){
+    TC_DAG_OFFSET const *ptr = (TC_DAG_OFFSET const *) D->ptr;
+    TC_DAG_RANK const *adj = (TC_DAG_RANK const *) D->adj;
+    long *cost = (long *) malloc(((size_t) D->n + 1) * sizeof(long));
+    if (cost == NULL)
+        return NULL;
+
+    cost[0] = 0;
+    for (int u = 0; u < D->n; u++){
+        long out = ptr[u+1] - ptr[u];
+        long work = 1 + out*out;
+        for (int64_t k = ptr[u]; k < (int64_t) ptr[u+1]; k++)
+            work += ptr[adj[k]+1] - ptr[adj[k]];
+        cost[u+1] = cost[u] + work;
+    }
+    return cost;
+}
+
+#undef TC_DAG_NAME
+#undef TC_DAG_PASTE
+#undef TC_DAG_PASTE2
+#undef TC_DAG_RANK
+#undef TC_DAG_OFFSET
+#undef TC_DAG_SUFFIX
@@ -0,0 +1,53 @@
+/*
+** tc_sched.c -- work estimates for splitting the column loop
+*/
+
+#include <stdlib.h>
+
+#include "tc_sched.h"
+
+long *tc_sched_cost(const int *csc_row, const int64_t *csc_col, int n, int bitmap_degree){
+    long *cost = (long *) malloc(((size_t) n + 1) * sizeof(long));
+    if (cost == NULL)
+        return NULL;
+
+    cost[0] = 0;
+    for (int j = 0; j < n; j++){
+        long degj = csc_col[j+1] - csc_col[j];
+        long work = 1 + (degj > bitmap_degree ? degj : degj*degj);
+        for (int64_t k = csc_col[j]; k < csc_col[j+1]; k++)
+            work += csc_col[csc_row[k]+1] - csc_col[csc_row[k]];
+        cost[j+1] = cost[j] + work;
+    }
+    return cost;
+}
+
+/* First column m in [lo, hi] with cost[m] >= target */
+static int lower_bound(const long *cost, int lo, int hi, long target){
+    while (lo < hi){
+        int mid = lo + (hi - lo)/2;
+        if (cost[mid] < target)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+int tc_sched_split(const long *cost, int lo, int hi){
+    int m = lower_bound(cost, lo, hi, cost[lo] + (cost[hi] - cost[lo])/2);
+    if (m <= lo)
+        m = lo + 1;
+    if (m >= hi)
+        m = hi - 1;
+    return m;
+}
+
+void tc_sched_partition(const long *cost, int n, int nparts, int *bounds){
+    long total = cost[n];
+
+    bounds[0] = 0;
+    for (int p = 1; p < nparts; p++)
+        bounds[p] = lower_bound(cost, bounds[p-1], n, total / nparts * p + total % nparts * p / nparts);
+    bounds[nparts] = n;
+}
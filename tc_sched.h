@@ -0,0 +1,39 @@
+/*
+** tc_sched.h -- work estimates for splitting the column loop
+**
+** Counting column j intersects its list with the list of every
+** neighbour i, so its work is estimated as the sum of deg(i) + deg(j)
+** over the entries of j. On power-law graphs this differs by orders of
+** magnitude between columns, so ranges are cut by estimated work
+** rather than by column count.
+*/
+
+#ifndef TC_SCHED_H
+#define TC_SCHED_H
+
+#include <stdint.h>
+
+/*
+** Prefix sum of the estimated work: cost[j+1] - cost[j] is the work of
+** column j, plus one so that empty columns are not free. Columns with
+** more than bitmap_degree entries are counted against a bitmap instead,
+** which costs deg(j) plus the sum of deg(i); pass -1 when every column
+** is, INT_MAX when none is. Returns an array of n+1 entries to be freed
+** by the caller, or NULL when the memory is not available.
+*/
+long *tc_sched_cost(const int *csc_row, const int64_t *csc_col, int n, int bitmap_degree);
+
+/*
+** Column m in (lo, hi) that splits [lo, hi) into two ranges of about
+** equal work. The range must hold at least two columns.
+*/
+int tc_sched_split(const long *cost, int lo, int hi);
+
+/*
+** Cut [0, n) into nparts ranges of about equal work: range p is
+** [bounds[p], bounds[p+1]). bounds holds nparts+1 entries; ranges may
+** be empty when single columns outweigh a whole share.
+*/
+void tc_sched_partition(const long *cost, int n, int nparts, int *bounds);
+
+#endif
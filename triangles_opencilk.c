@@ -1,182 +1,88 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include <cilk/cilk.h>
-#include "mmio.h"
-
-void quicksort(int element_list[], int low, int high){
-	int pivot, value1, value2, temp;
-	if (low < high){
-		pivot = low;
-		value1 = low;
-		value2 = high;
-		while (value1 < value2){
-			while (element_list[value1] <= element_list[pivot] && value1 <= high){
-				value1++;
-			}
-			while (element_list[value2] > element_list[pivot] && value2 >= low){
-				value2--;
-			}
-			if (value1 < value2){
-				temp = element_list[value1];
-				element_list[value1] = element_list[value2];
-				element_list[value2] = temp;
-			}
-		}
-		temp = element_list[value2];
-		element_list[value2] = element_list[pivot];
-		element_list[pivot] = temp;
-		quicksort(element_list, low, value2 - 1);
-		quicksort(element_list, value2 + 1, high);
-	}
-}
-
-void coo2csc(
-    int       * const row,       /*!< CSC row start indices */
-    int       * const col,       /*!< CSC column indices */
-    int const * const row_coo,   /*!< COO row indices */
-    int const * const col_coo,   /*!< COO column indices */
-    int const         nnz,       /*!< Number of nonzero elements */
-    int const         n,         /*!< Number of rows/columns */
-    int const         isOneBased /*!< Whether COO is 0- or 1-based */
-) {
-
-    // ----- cannot assume that input is already 0!
-    for (int l = 0; l < n+1; l++) col[l] = 0;
-
-    // ----- find the correct column sizes
-    for (int l = 0; l < nnz; l++)
-        col[col_coo[l] - isOneBased]++;
-
-    // ----- cumulative sum
-    for (int i = 0, cumsum = 0; i < n; i++){
-        int temp = col[i];
-        col[i] = cumsum;
-        cumsum += temp;
-    }
-    col[n] = nnz;
-
-    // ----- copy the row indices to the correct place
-    for (int l=0; l < nnz; l++){
-        int col_l;
-        col_l = col_coo[l] - isOneBased;
-
-        int dst = col[col_l];
-        row[dst] = row_coo[l] - isOneBased;
-
-        col[col_l]++;
+#include <cilk/cilk_api.h>
+#include <cilk/reducer.h>
+#include <cilk/reducer_opadd.h>
+#include "intersect.h"
+#include "tc_counts.h"
+#include "tc_dag.h"
+#include "tc_credit.h"
+#include "csc_varint.h"
+#include "csc_reorder.h"
+#include "csc_graph.h"
+
+enum { KERNEL_MASKED, KERNEL_BITMAP, KERNEL_DAG, KERNEL_VARINT };
+
+static long count_column(int const *csc_row, int64_t const *csc_col, int N,
+                        intersect_bitmap **marks, const csc_varint *varint,
+                        int kernel, int j){
+
+    // ----- varint kernel: merge the gap-encoded lists
+    if (kernel == KERNEL_VARINT)
+        return csc_varint_column(varint, j, __cilkrts_get_worker_number());
+
+    // ----- bitmap kernel: mark the rows of j, probe its neighbours against them
+    if (kernel == KERNEL_BITMAP){
+        int w = __cilkrts_get_worker_number();
+        if (marks[w] == NULL)
+            marks[w] = intersect_bitmap_acquire(N);
+        if (marks[w] != NULL)
+            return intersect_bitmap_column(marks[w], csc_row, csc_col, j);
     }
 
-    // ----- revert the column pointers
-    for (int i=0, last=0; i<n; i++){
-        int temp = col[i];
-        col[i] = last;
-        last = temp;
-    }
+    return intersect_masked_column(csc_row, csc_col, N, j);
 }
 
-
 int main(int argc, char *argv[]){
 
-    int ret_code;
-    MM_typecode matcode;
-    FILE *f;
-    int M, N, nnz;
-    int *coo_row, *coo_col;
-    double *val;
+    int N;
+    int *csc_row;
+    int64_t *csc_col;
+    int kernel = KERNEL_MASKED;
+    int order = CSC_REORDER_NONE;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:g:b:r:v")) != -1){
+        if (opt == 'k' && strcmp(optarg, "masked") == 0)
+            kernel = KERNEL_MASKED;
+        else if (opt == 'k' && strcmp(optarg, "bitmap") == 0)
+            kernel = KERNEL_BITMAP;
+        else if (opt == 'k' && strcmp(optarg, "dag") == 0)
+            kernel = KERNEL_DAG;
+        else if (opt == 'k' && strcmp(optarg, "varint") == 0)
+            kernel = KERNEL_VARINT;
+        else if (opt == 'g')
+            intersect_skew = atoi(optarg);
+        else if (opt == 'b')
+            intersect_hub_degree = atoi(optarg);
+        else if (opt == 'r' && csc_reorder_parse(optarg) >= 0)
+            order = csc_reorder_parse(optarg);
+        else if (opt == 'v')
+            csc_graph_verify = 1;
+        else
+            optind = argc;
+    }
 
-    if (argc < 2)
+    if (optind != argc-1)
 	{
-		fprintf(stderr, "Usage: %s [martix-market-filename]\n", argv[0]);
+		fprintf(stderr, "Usage: %s [-k masked|bitmap|dag|varint] [-g galloping-ratio] [-b hub-degree] [-r none|degree|rcm|gorder] [-v] [martix-market-filename]\n", argv[0]);
 		exit(1);
 	}
-    else
-    {
-        if ((f = fopen(argv[1], "r")) == NULL) 
-            exit(1);
-    }
-
-    if (mm_read_banner(f, &matcode) != 0){
-        printf("Could not process Matrix Market banner.\n");
-        exit(1);
-    }
+    const char *filename = argv[optind];
 
+    printf("Intersection: %s\n", intersect_init(NULL));
 
-    if (mm_is_complex(matcode) || mm_is_dense(matcode) || mm_is_hermitian(matcode)){
-        printf("Sorry, this application does not support ");
-        printf("Market Market type: [%s]\n", mm_typecode_to_str(matcode));
+    csc_graph G;
+    if (csc_graph_load(filename, __cilkrts_get_nworkers(), order, &G) != 0)
         exit(1);
-    }
-
-    /* find out size of sparse matrix .... */
-
-    if ((ret_code = mm_read_mtx_crd_size(f, &M, &N, &nnz)) !=0)
-        exit(1);
-
-
-    /* reseve memory for matrices */
-
-    coo_row = (int *) malloc(nnz * sizeof(int));
-    coo_col = (int *) malloc(nnz * sizeof(int));
-    val = (double *) malloc(nnz * sizeof(double));
-
-    /* Replace missing val column with 1s and change the fscanf to match patter matrices*/
-
-    if (!mm_is_pattern(matcode)){
-
-        for (int i=0; i<nnz; i++)
-            fscanf(f, "%d %d %lg\n", &coo_row[i], &coo_col[i], &val[i]);
-
-    }
-    else{
-
-        for (int i=0; i<nnz; i++){
-            fscanf(f, "%d %d\n", &coo_row[i], &coo_col[i]);
-            val[i]=1;
-        }
-    }
-
-    if (f !=stdin) fclose(f);
-
-    int *cooFull_row = (int *) malloc((2*nnz)*sizeof(int));
-    int *cooFull_col = (int *) malloc((2*nnz)*sizeof(int));
-    int *valFull = (int *) malloc((2*nnz)*sizeof(int));
-
-    for(int i=0; i<nnz; i++){
-        cooFull_row[i] = coo_row[i];
-        cooFull_row[nnz+i] = coo_col[i];
-        cooFull_col[i] = coo_col[i];
-        cooFull_col[nnz+i] = coo_row[i];
-        valFull[i] = 0;
-        valFull[nnz+i] = 0;
-    }
-
-    /* Write out the matrix */
-    /*
-    mm_write_banner(stdout, matcode);
-    mm_write_mtx_crd_size(stdout, M, N, nnz);
-    for (int i=0; i<nnz; i++)
-        fprintf(stdout, "%d %d %g   %d %d\n",
-                coo_row[i], coo_col[i], val[i], cooFull_row[nnz+i], cooFull_col[nnz+i]);
-    */
-
-    free(coo_row);
-    free(coo_col);
-    free(val);
-
-    int *csc_row = (int *)malloc((2*nnz)*sizeof(int));
-    int *csc_col = (int *)malloc((N+1)*sizeof(int));
-
-    coo2csc(csc_row, csc_col,
-            cooFull_row, cooFull_col,
-            2*nnz, N, 1);
-
-    free(cooFull_row);
-    free(cooFull_col);
-
-    for(int i=0; i<N+1; i++){
-        quicksort(csc_row, csc_col[i], csc_col[i+1]-1);
-    }
+    N = G.N;
+    csc_row = G.csc_row;
+    csc_col = G.csc_col;
     
     // printf("csc_col: ");
     // for(int i=0; i<N+1; i++)
@@ -188,69 +94,119 @@ int main(int argc, char *argv[]){
     // printf("nnz: %d\n", nnz);
     
 
-    int c3[N];
 
-    for(int i=0; i<N; i++)
-        c3[i]=0;
+    int64_t *c3 = tc_counts_alloc(N);
+    if (c3 == NULL){
+        printf("Could not allocate the counts of %d vertices.\n", N);
+        exit(1);
+    }
 
 
     struct timespec start;
     struct timespec stop;
     struct timespec duration;
 
+    // ----- one scratch bitmap per worker, taken on its first column
+    int nworkers = __cilkrts_get_nworkers();
+    intersect_bitmap **marks = (intersect_bitmap **) calloc(nworkers, sizeof(intersect_bitmap *));
+    if (marks == NULL){
+        printf("Could not allocate the bitmaps of %d workers.\n", nworkers);
+        exit(1);
+    }
+
+    const char *dag_layout = NULL;
+    const char *credit_name = NULL;
+    size_t dag_bytes = 0;
+    size_t varint_bytes = 0;
+
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-	cilk_for(int j=0; j<N; j++){
-        
-        int nzrangeOfColA = csc_col[j+1]-csc_col[j];
-        int colA[nzrangeOfColA];
-        for(int y=csc_col[j]; y<csc_col[j+1]; y++){
-            colA[y-csc_col[j]] = csc_row[y];
+    CILK_C_REDUCER_OPADD(total, long, 0);
+    CILK_C_REGISTER_REDUCER(total);
+
+    if (kernel == KERNEL_DAG){
+        tc_dag D;
+        if (tc_dag_build(csc_row, csc_col, N, &D) != 0){
+            printf("Could not allocate the DAG of %d vertices.\n", N);
+            exit(1);
+        }
+        dag_layout = tc_dag_width_name(D.width);
+        dag_bytes = tc_dag_bytes(&D);
+
+        // ----- corners go through per-worker credits: nothing O(N) per steal or join
+        tc_credit credit;
+        if (tc_credit_init(&credit, N, nworkers, TC_CREDIT_AUTO, c3) != 0){
+            printf("Could not allocate the credits of %d vertices.\n", N);
+            exit(1);
         }
-        
-        for(int n=csc_col[j]; n<csc_col[j+1]; n++){
-            
-            int i = csc_row[n];
-            /*
-            ** Iterate all the non zero values of matrix A
-            ** A(i,j) !=  0 
-            */
-            int nnzrangeOfRowA = csc_col[i+1]-csc_col[i];       
-            int rowA[nnzrangeOfRowA];       
-            for(int x=csc_col[i]; x<csc_col[i+1]; x++){
-                rowA[x-csc_col[i]] = csc_row[x];
-            }
 
-            int common = 0;
-            int flag = 0;
-            for(int l=0; l<nnzrangeOfRowA; l++){
-                int counter = 0;
-                while((counter + flag) < nzrangeOfColA){
-                if(rowA[l] < colA[counter+flag]){
-                    counter++;
-                    break;
-                }else if(rowA[l] == colA[counter+flag]){
-                    common++;
-                    break;
-                }else
-                    flag++;
-                }
+        // ----- every triangle once, from its lowest ranked corner, credited to all three
+        cilk_for(int r=0; r<N; r++)
+            REDUCER_VIEW(total) += tc_dag_count_credit(&D, r, r+1, &credit,
+                                                       __cilkrts_get_worker_number());
+
+        tc_credit_finish(&credit);
+        credit_name = tc_credit_name(&credit);
+        tc_credit_free(&credit);
+        tc_dag_free(&D);
+    }else{
+        csc_varint V;
+        if (kernel == KERNEL_VARINT){
+            if (csc_varint_build(csc_row, csc_col, N, nworkers, &V) != 0){
+                printf("Could not allocate the compressed adjacency.\n");
+                exit(1);
             }
-            c3[j] += common;            
-        }        
+            varint_bytes = csc_varint_bytes(&V);
+        }
+
+        cilk_for(int j=0; j<N; j++){
+            long c = count_column(csc_row, csc_col, N, marks, &V, kernel, j);
+            c3[j] += c;
+            REDUCER_VIEW(total) += c;
+        }
+
+        if (kernel == KERNEL_VARINT)
+            csc_varint_free(&V);
     }
 
-    clock_gettime(CLOCK_MONOTONIC, &stop);
+    long triangles = REDUCER_VIEW(total);
+    CILK_C_UNREGISTER_REDUCER(total);
 
-    free(csc_row);
-    free(csc_col);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
 
+    for(int w=0; w<nworkers; w++)
+        if (marks[w] != NULL)
+            intersect_bitmap_release(marks[w]);
+    free(marks);
+
+    intersect_stats stats;
+    intersect_get_stats(&stats);
+    printf("Intersections: %ld merged, %ld galloping, %ld against bitmaps",
+           stats.merge, stats.galloping, stats.bitmap);
+    printf(" (galloping ratio %d, hub degree %d)\n", intersect_skew, intersect_hub_degree);
+    printf("Triangles: %ld\n", kernel == KERNEL_DAG ? triangles : triangles/6);
+    intersect_free_scratch();
+
+    printf("Memory: %.1f MB of CSC, %.1f MB of counts, %.1f MB peak resident\n",
+           csc_graph_bytes(&G)/(1024.0*1024.0),
+           tc_counts_bytes(N)/(1024.0*1024.0), tc_peak_rss()/(1024.0*1024.0));
+    if (credit_name != NULL)
+        printf("Credits: %s\n", credit_name);
+    if (dag_layout != NULL)
+        printf("DAG: %s, %.1f MB\n", dag_layout, dag_bytes/(1024.0*1024.0));
+    if (varint_bytes > 0)
+        printf("Varint: %.1f MB, %.2fx smaller than the CSC\n", varint_bytes/(1024.0*1024.0),
+               csc_graph_bytes(&G)/(double) varint_bytes);
+
+    csc_graph_restore(&G, c3);
+    csc_graph_free(&G);
+
+    // ----- the masked product finds every triangle twice per vertex
     printf("\nC3:\n");
     for(int i=0; i<N; i++){
-        if(c3[i]%2 != 0)
-            c3[i]++;
-        c3[i] = c3[i]/2;
-        printf("%d %d\n", i, c3[i]);
+        if (kernel != KERNEL_DAG)
+            c3[i] = c3[i]/2;
+        printf("%d %" PRId64 "\n", i, c3[i]);
     }
 
     duration.tv_sec = stop.tv_sec - start.tv_sec;
@@ -266,6 +222,8 @@ int main(int argc, char *argv[]){
 
     printf("The process took %ld seconds and %ld nanoseconds", duration.tv_sec, duration.tv_nsec);
 
+    tc_counts_free(c3, N);
+
 
 	return 0;
 }
@@ -1,182 +1,103 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include <omp.h>
-#include "mmio.h"
-
-void quicksort(int element_list[], int low, int high){
-	int pivot, value1, value2, temp;
-	if (low < high){
-		pivot = low;
-		value1 = low;
-		value2 = high;
-		while (value1 < value2){
-			while (element_list[value1] <= element_list[pivot] && value1 <= high){
-				value1++;
-			}
-			while (element_list[value2] > element_list[pivot] && value2 >= low){
-				value2--;
-			}
-			if (value1 < value2){
-				temp = element_list[value1];
-				element_list[value1] = element_list[value2];
-				element_list[value2] = temp;
-			}
-		}
-		temp = element_list[value2];
-		element_list[value2] = element_list[pivot];
-		element_list[pivot] = temp;
-		quicksort(element_list, low, value2 - 1);
-		quicksort(element_list, value2 + 1, high);
-	}
-}
+#include "intersect.h"
+#include "tc_counts.h"
+#include "tc_sched.h"
+#include "tc_dag.h"
+#include "tc_credit.h"
+#include "csc_varint.h"
+#include "csc_reorder.h"
+#include "csc_graph.h"
 
-void coo2csc(
-    int       * const row,       /*!< CSC row start indices */
-    int       * const col,       /*!< CSC column indices */
-    int const * const row_coo,   /*!< COO row indices */
-    int const * const col_coo,   /*!< COO column indices */
-    int const         nnz,       /*!< Number of nonzero elements */
-    int const         n,         /*!< Number of rows/columns */
-    int const         isOneBased /*!< Whether COO is 0- or 1-based */
-) {
-
-    // ----- cannot assume that input is already 0!
-    for (int l = 0; l < n+1; l++) col[l] = 0;
-
-    // ----- find the correct column sizes
-    for (int l = 0; l < nnz; l++)
-        col[col_coo[l] - isOneBased]++;
-
-    // ----- cumulative sum
-    for (int i = 0, cumsum = 0; i < n; i++){
-        int temp = col[i];
-        col[i] = cumsum;
-        cumsum += temp;
-    }
-    col[n] = nnz;
+enum { KERNEL_MASKED, KERNEL_BITMAP, KERNEL_DAG, KERNEL_VARINT };
+enum { SCHED_STATIC, SCHED_DYNAMIC, SCHED_GUIDED, SCHED_BALANCED };
 
-    // ----- copy the row indices to the correct place
-    for (int l=0; l < nnz; l++){
-        int col_l;
-        col_l = col_coo[l] - isOneBased;
+static const char *sched_names[] = { "static", "dynamic", "guided", "balanced" };
 
-        int dst = col[col_l];
-        row[dst] = row_coo[l] - isOneBased;
+static long count_column(int const *csc_row, int64_t const *csc_col, int N,
+                        intersect_bitmap *marks, const csc_varint *varint, int t, int j){
 
-        col[col_l]++;
-    }
+    // ----- varint kernel: merge the gap-encoded lists
+    if (varint != NULL)
+        return csc_varint_column(varint, j, t);
 
-    // ----- revert the column pointers
-    for (int i=0, last=0; i<n; i++){
-        int temp = col[i];
-        col[i] = last;
-        last = temp;
-    }
-}
+    // ----- bitmap kernel: mark the rows of j, probe its neighbours against them
+    if (marks != NULL)
+        return intersect_bitmap_column(marks, csc_row, csc_col, j);
 
+    return intersect_masked_column(csc_row, csc_col, N, j);
+}
 
 int main(int argc, char *argv[]){
 
-    int ret_code;
-    MM_typecode matcode;
-    FILE *f;
-    int M, N, nnz;
-    int *coo_row, *coo_col;
-    double *val;
+    int N;
+    int *csc_row;
+    int64_t *csc_col;
+    int kernel = KERNEL_MASKED;
+    int order = CSC_REORDER_NONE;
+    int sched = SCHED_STATIC;
+    int chunk = 0;
+    int credit_mode = TC_CREDIT_AUTO;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:s:c:a:g:b:r:v")) != -1){
+        if (opt == 'k' && strcmp(optarg, "masked") == 0)
+            kernel = KERNEL_MASKED;
+        else if (opt == 'k' && strcmp(optarg, "bitmap") == 0)
+            kernel = KERNEL_BITMAP;
+        else if (opt == 'k' && strcmp(optarg, "dag") == 0)
+            kernel = KERNEL_DAG;
+        else if (opt == 'k' && strcmp(optarg, "varint") == 0)
+            kernel = KERNEL_VARINT;
+        else if (opt == 's' && strcmp(optarg, "static") == 0)
+            sched = SCHED_STATIC;
+        else if (opt == 's' && strcmp(optarg, "dynamic") == 0)
+            sched = SCHED_DYNAMIC;
+        else if (opt == 's' && strcmp(optarg, "guided") == 0)
+            sched = SCHED_GUIDED;
+        else if (opt == 's' && strcmp(optarg, "balanced") == 0)
+            sched = SCHED_BALANCED;
+        else if (opt == 'c')
+            chunk = atoi(optarg);
+        else if (opt == 'a' && strcmp(optarg, "auto") == 0)
+            credit_mode = TC_CREDIT_AUTO;
+        else if (opt == 'a' && strcmp(optarg, "atomic") == 0)
+            credit_mode = TC_CREDIT_ATOMIC;
+        else if (opt == 'a' && strcmp(optarg, "buffered") == 0)
+            credit_mode = TC_CREDIT_BUFFERED;
+        else if (opt == 'g')
+            intersect_skew = atoi(optarg);
+        else if (opt == 'b')
+            intersect_hub_degree = atoi(optarg);
+        else if (opt == 'r' && csc_reorder_parse(optarg) >= 0)
+            order = csc_reorder_parse(optarg);
+        else if (opt == 'v')
+            csc_graph_verify = 1;
+        else
+            optind = argc;
+    }
 
-    if (argc < 2)
+    if (optind != argc-1)
 	{
-		fprintf(stderr, "Usage: %s [martix-market-filename]\n", argv[0]);
+		fprintf(stderr, "Usage: %s [-k masked|bitmap|dag|varint] [-s static|dynamic|guided|balanced] [-c chunk] [-a auto|atomic|buffered] [-g galloping-ratio] [-b hub-degree] [-r none|degree|rcm|gorder] [-v] [martix-market-filename]\n", argv[0]);
 		exit(1);
 	}
-    else
-    {
-        if ((f = fopen(argv[1], "r")) == NULL) 
-            exit(1);
-    }
-
-    if (mm_read_banner(f, &matcode) != 0){
-        printf("Could not process Matrix Market banner.\n");
-        exit(1);
-    }
-
-
-    if (mm_is_complex(matcode) || mm_is_dense(matcode) || mm_is_hermitian(matcode)){
-        printf("Sorry, this application does not support ");
-        printf("Market Market type: [%s]\n", mm_typecode_to_str(matcode));
-        exit(1);
-    }
+    const char *filename = argv[optind];
 
-    /* find out size of sparse matrix .... */
+    printf("Intersection: %s\n", intersect_init(NULL));
 
-    if ((ret_code = mm_read_mtx_crd_size(f, &M, &N, &nnz)) !=0)
+    csc_graph G;
+    if (csc_graph_load(filename, omp_get_max_threads(), order, &G) != 0)
         exit(1);
-
-
-    /* reseve memory for matrices */
-
-    coo_row = (int *) malloc(nnz * sizeof(int));
-    coo_col = (int *) malloc(nnz * sizeof(int));
-    val = (double *) malloc(nnz * sizeof(double));
-
-    /* Replace missing val column with 1s and change the fscanf to match patter matrices*/
-
-    if (!mm_is_pattern(matcode)){
-
-        for (int i=0; i<nnz; i++)
-            fscanf(f, "%d %d %lg\n", &coo_row[i], &coo_col[i], &val[i]);
-
-    }
-    else{
-
-        for (int i=0; i<nnz; i++){
-            fscanf(f, "%d %d\n", &coo_row[i], &coo_col[i]);
-            val[i]=1;
-        }
-    }
-
-    if (f !=stdin) fclose(f);
-
-    int *cooFull_row = (int *) malloc((2*nnz)*sizeof(int));
-    int *cooFull_col = (int *) malloc((2*nnz)*sizeof(int));
-    int *valFull = (int *) malloc((2*nnz)*sizeof(int));
-
-    for(int i=0; i<nnz; i++){
-        cooFull_row[i] = coo_row[i];
-        cooFull_row[nnz+i] = coo_col[i];
-        cooFull_col[i] = coo_col[i];
-        cooFull_col[nnz+i] = coo_row[i];
-        valFull[i] = 0;
-        valFull[nnz+i] = 0;
-    }
-
-    /* Write out the matrix */
-    /*
-    mm_write_banner(stdout, matcode);
-    mm_write_mtx_crd_size(stdout, M, N, nnz);
-    for (int i=0; i<nnz; i++)
-        fprintf(stdout, "%d %d %g   %d %d\n",
-                coo_row[i], coo_col[i], val[i], cooFull_row[nnz+i], cooFull_col[nnz+i]);
-    */
-
-    free(coo_row);
-    free(coo_col);
-    free(val);
-
-    int *csc_row = (int *)malloc((2*nnz)*sizeof(int));
-    int *csc_col = (int *)malloc((N+1)*sizeof(int));
-
-    coo2csc(csc_row, csc_col,
-            cooFull_row, cooFull_col,
-            2*nnz, N, 1);
-
-    free(cooFull_row);
-    free(cooFull_col);
-
-    for(int i=0; i<N+1; i++){
-        quicksort(csc_row, csc_col[i], csc_col[i+1]-1);
-    }
+    N = G.N;
+    csc_row = G.csc_row;
+    csc_col = G.csc_col;
     
     // printf("csc_col: ");
     // for(int i=0; i<N+1; i++)
@@ -188,72 +109,176 @@ int main(int argc, char *argv[]){
     // printf("nnz: %d\n", nnz);
     
 
-    int c3[N];
 
-    for(int i=0; i<N; i++)
-        c3[i]=0;
+    int64_t *c3 = tc_counts_alloc(N);
+    if (c3 == NULL){
+        printf("Could not allocate the counts of %d vertices.\n", N);
+        exit(1);
+    }
 
 
     struct timespec start;
     struct timespec stop;
     struct timespec duration;
 
+    const char *dag_layout = NULL;
+    size_t dag_bytes = 0;
+    size_t varint_bytes = 0;
+
     clock_gettime(CLOCK_MONOTONIC, &start);
     
-    #pragma omp parallel
-    #pragma omp for
-	for(int j=0; j<N; j++){
-        
-        int nzrangeOfColA = csc_col[j+1]-csc_col[j];
-        int colA[nzrangeOfColA];
-        for(int y=csc_col[j]; y<csc_col[j+1]; y++){
-            colA[y-csc_col[j]] = csc_row[y];
+    int nthreads = omp_get_max_threads();
+    double busy[nthreads];
+    int bounds[nthreads+1];
+
+    // ----- columns above this degree are counted against a bitmap
+    int bitmap_degree = INT_MAX;
+    if (kernel == KERNEL_BITMAP)
+        bitmap_degree = -1;
+    else if (intersect_hub_degree > 0 && kernel != KERNEL_VARINT)
+        bitmap_degree = intersect_hub_degree;
+
+    // ----- dag: any thread may credit any corner, through credit
+    tc_dag D;
+    tc_credit credit;
+    const char *credit_name = NULL;
+    if (kernel == KERNEL_DAG){
+        if (tc_dag_build(csc_row, csc_col, N, &D) != 0){
+            printf("Could not allocate the DAG of %d vertices.\n", N);
+            exit(1);
+        }
+        dag_layout = tc_dag_width_name(D.width);
+        dag_bytes = tc_dag_bytes(&D);
+        if (tc_credit_init(&credit, N, nthreads, credit_mode, c3) != 0){
+            printf("Could not allocate the credits of %d vertices.\n", N);
+            exit(1);
         }
+    }
 
-        for(int n=csc_col[j]; n<csc_col[j+1]; n++){
-            
-            int i = csc_row[n];
-            /*
-            ** Iterate all the non zero values of matrix A
-            ** A(i,j) !=  0 
-            */
-            int nnzrangeOfRowA = csc_col[i+1]-csc_col[i];       
-            int rowA[nnzrangeOfRowA];  
-            for(int x=csc_col[i]; x<csc_col[i+1]; x++){
-                rowA[x-csc_col[i]] = csc_row[x];
-            }
-        
-            int common = 0;
-            int flag = 0;
-                for(int l=0; l<nnzrangeOfRowA; l++){
-                    int counter = 0;
-                    while((counter + flag) < nzrangeOfColA){
-                    if(rowA[l] < colA[counter+flag]){
-                        counter++;
-                        break;
-                    }else if(rowA[l] == colA[counter+flag]){
-                        common++;
-                        break;
-                    }else
-                        flag++;
+    csc_varint V;
+    const csc_varint *varint = NULL;
+    if (kernel == KERNEL_VARINT){
+        if (csc_varint_build(csc_row, csc_col, N, nthreads, &V) != 0){
+            printf("Could not allocate the compressed adjacency.\n");
+            exit(1);
+        }
+        varint = &V;
+        varint_bytes = csc_varint_bytes(&V);
+    }
+
+    // ----- balanced: one range of equal estimated work per thread
+    long *cost = NULL;
+    if (sched == SCHED_BALANCED){
+        cost = (kernel == KERNEL_DAG) ?
+               tc_dag_cost(&D) :
+               tc_sched_cost(csc_row, csc_col, N, bitmap_degree);
+        if (cost == NULL){
+            printf("Could not allocate the work estimates, scheduling static instead.\n");
+            sched = SCHED_STATIC;
+        }
+    }
+    if (sched == SCHED_BALANCED){
+        tc_sched_partition(cost, N, nthreads, bounds);
+        free(cost);
+    }else if (sched == SCHED_DYNAMIC)
+        omp_set_schedule(omp_sched_dynamic, chunk);
+    else if (sched == SCHED_GUIDED)
+        omp_set_schedule(omp_sched_guided, chunk);
+    else
+        omp_set_schedule(omp_sched_static, chunk);
+
+    for(int t=0; t<nthreads; t++)
+        busy[t] = 0;
+
+    #pragma omp parallel num_threads(nthreads)
+    {
+        int t = omp_get_thread_num();
+        double begin = omp_get_wtime();
+
+        intersect_bitmap *marks = NULL;
+        if (kernel == KERNEL_BITMAP)
+            marks = intersect_bitmap_acquire(N);
+
+        // ----- first touch: each thread zeroes the counts of the columns it starts on
+        if (sched == SCHED_BALANCED){
+            for(int r=t; r<nthreads; r+=omp_get_num_threads())
+                memset(c3 + bounds[r], 0, (size_t)(bounds[r+1] - bounds[r]) * sizeof(int64_t));
+            #pragma omp barrier
+        }else{
+            #pragma omp for schedule(static)
+            for(int j=0; j<N; j++)
+                c3[j] = 0;
+        }
+
+        if (sched == SCHED_BALANCED){
+            // ----- a smaller team than requested takes the ranges round robin
+            for(int r=t; r<nthreads; r+=omp_get_num_threads())
+                for(int j=bounds[r]; j<bounds[r+1]; j++){
+                    if (kernel == KERNEL_DAG)
+                        tc_dag_count_credit(&D, j, j+1, &credit, t);
+                    else
+                        c3[j] += count_column(csc_row, csc_col, N, marks, varint, t, j);
                 }
+        }else{
+            #pragma omp for schedule(runtime) nowait
+            for(int j=0; j<N; j++){
+                if (kernel == KERNEL_DAG)
+                    tc_dag_count_credit(&D, j, j+1, &credit, t);
+                else
+                    c3[j] += count_column(csc_row, csc_col, N, marks, varint, t, j);
             }
-            c3[j] += common;
-            
-        }        
+        }
+
+        if (marks != NULL)
+            intersect_bitmap_release(marks);
+
+        busy[t] = omp_get_wtime() - begin;
     }
 
-    clock_gettime(CLOCK_MONOTONIC, &stop);
+    if (kernel == KERNEL_DAG){
+        tc_credit_finish(&credit);
+        credit_name = tc_credit_name(&credit);
+        tc_credit_free(&credit);
+        tc_dag_free(&D);
+    }
+    if (varint != NULL)
+        csc_varint_free(&V);
 
-    free(csc_row);
-    free(csc_col);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
 
+    intersect_stats stats;
+    intersect_get_stats(&stats);
+    printf("Intersections: %ld merged, %ld galloping, %ld against bitmaps",
+           stats.merge, stats.galloping, stats.bitmap);
+    printf(" (galloping ratio %d, hub degree %d)\n", intersect_skew, intersect_hub_degree);
+    printf("Schedule: %s", sched_names[sched]);
+    if (chunk > 0 && sched != SCHED_BALANCED)
+        printf(", chunks of %d columns", chunk);
+    printf(", %d threads\n", nthreads);
+    for(int t=0; t<nthreads; t++)
+        printf("  thread %d: busy %.3f s\n", t, busy[t]);
+    if (credit_name != NULL)
+        printf("Credits: %s\n", credit_name);
+    intersect_free_scratch();
+
+    printf("Memory: %.1f MB of CSC, %.1f MB of counts, %.1f MB peak resident\n",
+           csc_graph_bytes(&G)/(1024.0*1024.0),
+           tc_counts_bytes(N)/(1024.0*1024.0), tc_peak_rss()/(1024.0*1024.0));
+    if (dag_layout != NULL)
+        printf("DAG: %s, %.1f MB\n", dag_layout, dag_bytes/(1024.0*1024.0));
+    if (varint_bytes > 0)
+        printf("Varint: %.1f MB, %.2fx smaller than the CSC\n", varint_bytes/(1024.0*1024.0),
+               csc_graph_bytes(&G)/(double) varint_bytes);
+
+    csc_graph_restore(&G, c3);
+    csc_graph_free(&G);
+
+    // ----- the masked product finds every triangle twice per vertex
     printf("\nC3:\n");
     for(int i=0; i<N; i++){
-        if(c3[i]%2 != 0)
-            c3[i]++;
-        c3[i] = c3[i]/2;
-        printf("%d %d\n", i, c3[i]);
+        if (kernel != KERNEL_DAG)
+            c3[i] = c3[i]/2;
+        printf("%d %" PRId64 "\n", i, c3[i]);
     }
 
     duration.tv_sec = stop.tv_sec - start.tv_sec;
@@ -269,6 +294,8 @@ int main(int argc, char *argv[]){
 
     printf("The process took %ld seconds and %ld nanoseconds", duration.tv_sec, duration.tv_nsec);
 
+    tc_counts_free(c3, N);
+
 
 	return 0;
 }
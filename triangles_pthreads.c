@@ -1,235 +1,301 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <string.h>
 #include <time.h>
 #include <pthread.h>
-#include "mmio.h"
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "intersect.h"
+#include "tc_counts.h"
+#include "tc_sched.h"
+#include "tc_dag.h"
+#include "tc_credit.h"
+#include "csc_varint.h"
+#include "csc_reorder.h"
+#include "csc_graph.h"
 
 #define MAX_THREAD 1000
+#define CHUNK_DEFAULT 64
+#define RANGES_PER_WORKER 4     /*!< Ranges every deque starts with */
+#define SPLITS_PER_WORKER 64    /*!< Ranges are split down to 1/(nthreads*64) of the work */
+#define DEQUE_SLACK 64          /*!< Deque room for the halves pushed back by splits */
 
+enum { KERNEL_MASKED, KERNEL_BITMAP, KERNEL_DAG, KERNEL_VARINT };
+enum { SCHED_STEAL, SCHED_CHUNK };
+
+typedef struct {
+    int lo, hi;
+} range;
+
+typedef struct worker worker;
+
+/*
+** The pool: a fixed number of workers count every column exactly once
+** (every rank of the DAG, for the dag kernel).
+** With the chunk scheduler they claim the next chunk of columns from a
+** shared cursor; with work stealing every worker owns a deque of ranges
+** cut by estimated work and steals from the others once it runs dry.
+*/
 typedef struct {
-    int j;
+    int n;
     int *csc_row;
-    int *csc_col;
-    int c;
+    int64_t *csc_col;
+    int kernel;
+    int chunk;
+    atomic_long *cursor;    /*!< First column not yet claimed by a worker */
+    int64_t *c3;
+    int nworkers;
+    worker *workers;
+    const long *cost;       /*!< Prefix sum of the estimated work per column */
+    long split_cost;        /*!< Ranges above this work are split before counting */
+    atomic_long *remaining; /*!< Columns not counted yet */
+    const tc_dag *dag;      /*!< The dag kernel counts ranks of this DAG... */
+    tc_credit *credit;      /*!< ...and credits all three corners through this */
+    const csc_varint *varint; /*!< The varint kernel merges these encoded lists */
+    pthread_barrier_t *touched; /*!< Passed once every worker has zeroed its counts */
 } parm;
 
-void *C(void *arg) {
-    parm *p = (parm *)arg;
-    int *row = p->csc_row;
-    int *col = p->csc_col;
-    int j = p->j;
-    int nzrangeOfColA = col[j+1]-col[j];
-    int colA[nzrangeOfColA];
-    for(int y=col[j]; y<col[(j)+1]; y++){
-        colA[y-col[j]] = row[y];
-    }
-
-    for(int n=col[j]; n<col[(j)+1]; n++){
-            
-        int i = row[n];
-        
-        // Iterate all the non zero values of matrix A
-        // A(i,j) !=  0 
-
-        int nnzrangeOfRowA = col[i+1]-col[i];       
-        int rowA[nnzrangeOfRowA];     
-        for(int x=col[i]; x<col[i+1]; x++){
-            rowA[x-col[i]] = row[x];
-        }
-          
-        int common = 0;
-        int flag = 0;
-        for(int l=0; l<nnzrangeOfRowA; l++){
-            int counter = 0;
-            while((counter + flag) < nzrangeOfColA){
-            if(rowA[l] < colA[counter+flag]){
-                counter++;
-                break;
-            }else if(rowA[l] == colA[counter+flag]){
-                common++;
-                break;
-            }else
-                flag++;            
-            }
-        }
-        p->c += common;        
-    }
-    pthread_exit(NULL);
+/*
+** Deque of column ranges owned by one worker: the owner pushes and pops
+** at the bottom, thieves take the oldest, largest range from the top.
+** Each worker sits on its own cache lines, so neither the counters its
+** owner updates nor the lock thieves take are shared with a neighbour.
+*/
+struct worker {
+    int id;
+    parm *p;
+    pthread_mutex_t lock;
+    range *ranges;
+    int top, bottom, capacity;
+    long ranges_done;       /*!< Ranges counted by this worker */
+    long steals;            /*!< Ranges taken from other workers */
+    double busy;            /*!< Seconds spent counting */
+    double idle;            /*!< Seconds spent looking for work */
+    long common;            /*!< Sum of the c3 entries counted by this worker */
+    int touch_lo, touch_hi; /*!< Counts this worker zeroes before any is counted */
+} __attribute__((aligned(64)));
+
+static double now(void){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec*1e-9;
 }
 
-void quicksort(int element_list[], int low, int high){
-	int pivot, value1, value2, temp;
-	if (low < high){
-		pivot = low;
-		value1 = low;
-		value2 = high;
-		while (value1 < value2){
-			while (element_list[value1] <= element_list[pivot] && value1 <= high){
-				value1++;
-			}
-			while (element_list[value2] > element_list[pivot] && value2 >= low){
-				value2--;
-			}
-			if (value1 < value2){
-				temp = element_list[value1];
-				element_list[value1] = element_list[value2];
-				element_list[value2] = temp;
-			}
-		}
-		temp = element_list[value2];
-		element_list[value2] = element_list[pivot];
-		element_list[pivot] = temp;
-		quicksort(element_list, low, value2 - 1);
-		quicksort(element_list, value2 + 1, high);
-	}
-}
+static long count_column(const parm *p, intersect_bitmap *marks, int thread, int j){
 
-void coo2csc(
-    int       * const row,       /*!< CSC row start indices */
-    int       * const col,       /*!< CSC column indices */
-    int const * const row_coo,   /*!< COO row indices */
-    int const * const col_coo,   /*!< COO column indices */
-    int const         nnz,       /*!< Number of nonzero elements */
-    int const         n,         /*!< Number of rows/columns */
-    int const         isOneBased /*!< Whether COO is 0- or 1-based */
-) {
-
-    // ----- cannot assume that input is already 0!
-    for (int l = 0; l < n+1; l++) col[l] = 0;
-
-    // ----- find the correct column sizes
-    for (int l = 0; l < nnz; l++)
-        col[col_coo[l] - isOneBased]++;
-
-    // ----- cumulative sum
-    for (int i = 0, cumsum = 0; i < n; i++){
-        int temp = col[i];
-        col[i] = cumsum;
-        cumsum += temp;
-    }
-    col[n] = nnz;
+    // ----- varint kernel: merge the gap-encoded lists
+    if (p->varint != NULL)
+        return csc_varint_column(p->varint, j, thread);
 
-    // ----- copy the row indices to the correct place
-    for (int l=0; l < nnz; l++){
-        int col_l;
-        col_l = col_coo[l] - isOneBased;
+    // ----- bitmap kernel: mark the rows of j, probe its neighbours against them
+    if (marks != NULL)
+        return intersect_bitmap_column(marks, p->csc_row, p->csc_col, j);
 
-        int dst = col[col_l];
-        row[dst] = row_coo[l] - isOneBased;
-
-        col[col_l]++;
-    }
+    return intersect_masked_column(p->csc_row, p->csc_col, p->n, j);
+}
 
-    // ----- revert the column pointers
-    for (int i=0, last=0; i<n; i++){
-        int temp = col[i];
-        col[i] = last;
-        last = temp;
+static int push_range(worker *w, range r){
+    pthread_mutex_lock(&w->lock);
+    if (w->bottom == w->capacity && w->top > 0){
+        memmove(w->ranges, w->ranges + w->top, (w->bottom - w->top)*sizeof(range));
+        w->bottom -= w->top;
+        w->top = 0;
     }
+    int ok = w->bottom < w->capacity;
+    if (ok)
+        w->ranges[w->bottom++] = r;
+    pthread_mutex_unlock(&w->lock);
+    return ok;
 }
 
+static int pop_range(worker *w, range *r){
+    pthread_mutex_lock(&w->lock);
+    int ok = w->bottom > w->top;
+    if (ok)
+        *r = w->ranges[--w->bottom];
+    pthread_mutex_unlock(&w->lock);
+    return ok;
+}
 
-int main(int argc, char *argv[]){
+static int steal_range(worker *w, range *r){
+    pthread_mutex_lock(&w->lock);
+    int ok = w->bottom > w->top;
+    if (ok)
+        *r = w->ranges[w->top++];
+    pthread_mutex_unlock(&w->lock);
+    return ok;
+}
 
-    int ret_code;
-    MM_typecode matcode;
-    FILE *f;
-    int M, N, nnz;
-    int *coo_row, *coo_col;
-    double *val;
+static void count_range(worker *w, intersect_bitmap *marks, range r){
+    parm *p = w->p;
+    long common = 0;
+    double t = now();
 
-    if (argc < 2)
-	{
-		fprintf(stderr, "Usage: %s [martix-market-filename]\n", argv[0]);
-		exit(1);
-	}
+    // ----- accumulate in a register, touch the worker once per range
+    if (p->kernel == KERNEL_DAG)
+        common = tc_dag_count_credit(p->dag, r.lo, r.hi, p->credit, w->id);
     else
-    {
-        if ((f = fopen(argv[1], "r")) == NULL) 
-            exit(1);
-    }
-
-    if (mm_read_banner(f, &matcode) != 0){
-        printf("Could not process Matrix Market banner.\n");
-        exit(1);
-    }
-
-
-    if (mm_is_complex(matcode) || mm_is_dense(matcode) || mm_is_hermitian(matcode)){
-        printf("Sorry, this application does not support ");
-        printf("Market Market type: [%s]\n", mm_typecode_to_str(matcode));
-        exit(1);
-    }
-
-    /* find out size of sparse matrix .... */
-
-    if ((ret_code = mm_read_mtx_crd_size(f, &M, &N, &nnz)) !=0)
-        exit(1);
+        for(int j=r.lo; j<r.hi; j++){
+            long c = count_column(p, marks, w->id, j);
+            p->c3[j] = c;
+            common += c;
+        }
+    w->busy += now() - t;
+    w->ranges_done++;
+    w->common += common;
+}
 
+/*
+** First touch: zero the counts of the columns this worker starts on, so
+** their pages land on its node, and wait until every block is zeroed.
+*/
+static void touch_counts(worker *w){
+    parm *p = w->p;
+    memset(p->c3 + w->touch_lo, 0, (size_t)(w->touch_hi - w->touch_lo) * sizeof(int64_t));
+    pthread_barrier_wait(p->touched);
+}
 
-    /* reseve memory for matrices */
+void *C(void *arg) {
+    worker *w = (worker *)arg;
+    parm *p = w->p;
 
-    coo_row = (int *) malloc(nnz * sizeof(int));
-    coo_col = (int *) malloc(nnz * sizeof(int));
-    val = (double *) malloc(nnz * sizeof(double));
+    touch_counts(w);
 
-    /* Replace missing val column with 1s and change the fscanf to match patter matrices*/
+    intersect_bitmap *marks = NULL;
+    if (p->kernel == KERNEL_BITMAP)
+        marks = intersect_bitmap_acquire(p->n);
 
-    if (!mm_is_pattern(matcode)){
+    for(;;){
+        long lo = atomic_fetch_add(p->cursor, p->chunk);
+        if (lo >= p->n)
+            break;
+        range r = { lo, (lo + p->chunk < p->n) ? lo + p->chunk : p->n };
+        count_range(w, marks, r);
+    }
 
-        for (int i=0; i<nnz; i++)
-            fscanf(f, "%d %d %lg\n", &coo_row[i], &coo_col[i], &val[i]);
+    if (marks != NULL)
+        intersect_bitmap_release(marks);
+    return NULL;
+}
 
-    }
-    else{
+void *steal_worker(void *arg) {
+    worker *w = (worker *)arg;
+    parm *p = w->p;
+
+    touch_counts(w);
+
+    intersect_bitmap *marks = NULL;
+    if (p->kernel == KERNEL_BITMAP)
+        marks = intersect_bitmap_acquire(p->n);
+
+    for(;;){
+        range r;
+        if (!pop_range(w, &r)){
+            // ----- own deque is empty: try the others until every column is counted
+            double t = now();
+            int found = 0;
+            while (!found && atomic_load(p->remaining) > 0){
+                for(int k=1; k<p->nworkers && !found; k++)
+                    found = steal_range(&p->workers[(w->id + k) % p->nworkers], &r);
+                if (!found)
+                    sched_yield();
+            }
+            w->idle += now() - t;
+            if (!found)
+                break;
+            w->steals++;
+        }
 
-        for (int i=0; i<nnz; i++){
-            fscanf(f, "%d %d\n", &coo_row[i], &coo_col[i]);
-            val[i]=1;
+        // ----- keep the lower half, leave the upper half for thieves
+        while (r.hi - r.lo > 1 && p->cost[r.hi] - p->cost[r.lo] > p->split_cost){
+            int m = tc_sched_split(p->cost, r.lo, r.hi);
+            range upper = { m, r.hi };
+            if (!push_range(w, upper))
+                break;
+            r.hi = m;
         }
+
+        count_range(w, marks, r);
+        atomic_fetch_sub(p->remaining, r.hi - r.lo);
     }
 
-    if (f !=stdin) fclose(f);
+    if (marks != NULL)
+        intersect_bitmap_release(marks);
+    return NULL;
+}
 
-    int *cooFull_row = (int *) malloc((2*nnz)*sizeof(int));
-    int *cooFull_col = (int *) malloc((2*nnz)*sizeof(int));
-    int *valFull = (int *) malloc((2*nnz)*sizeof(int));
+int main(int argc, char *argv[]){
 
-    for(int i=0; i<nnz; i++){
-        cooFull_row[i] = coo_row[i];
-        cooFull_row[nnz+i] = coo_col[i];
-        cooFull_col[i] = coo_col[i];
-        cooFull_col[nnz+i] = coo_row[i];
-        valFull[i] = 0;
-        valFull[nnz+i] = 0;
+    int N;
+    int *csc_row;
+    int64_t *csc_col;
+    int kernel = KERNEL_MASKED;
+    int order = CSC_REORDER_NONE;
+    int nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    int chunk = CHUNK_DEFAULT;
+    int sched = SCHED_STEAL;
+    int credit_mode = TC_CREDIT_AUTO;
+    int opt;
+
+    if (nthreads > MAX_THREAD)
+        nthreads = MAX_THREAD;
+
+    while ((opt = getopt(argc, argv, "k:s:t:c:a:g:b:r:v")) != -1){
+        if (opt == 'k' && strcmp(optarg, "masked") == 0)
+            kernel = KERNEL_MASKED;
+        else if (opt == 'k' && strcmp(optarg, "bitmap") == 0)
+            kernel = KERNEL_BITMAP;
+        else if (opt == 'k' && strcmp(optarg, "dag") == 0)
+            kernel = KERNEL_DAG;
+        else if (opt == 'k' && strcmp(optarg, "varint") == 0)
+            kernel = KERNEL_VARINT;
+        else if (opt == 's' && strcmp(optarg, "steal") == 0)
+            sched = SCHED_STEAL;
+        else if (opt == 's' && strcmp(optarg, "chunk") == 0)
+            sched = SCHED_CHUNK;
+        else if (opt == 't')
+            nthreads = atoi(optarg);
+        else if (opt == 'c')
+            chunk = atoi(optarg);
+        else if (opt == 'a' && strcmp(optarg, "auto") == 0)
+            credit_mode = TC_CREDIT_AUTO;
+        else if (opt == 'a' && strcmp(optarg, "atomic") == 0)
+            credit_mode = TC_CREDIT_ATOMIC;
+        else if (opt == 'a' && strcmp(optarg, "buffered") == 0)
+            credit_mode = TC_CREDIT_BUFFERED;
+        else if (opt == 'g')
+            intersect_skew = atoi(optarg);
+        else if (opt == 'b')
+            intersect_hub_degree = atoi(optarg);
+        else if (opt == 'r' && csc_reorder_parse(optarg) >= 0)
+            order = csc_reorder_parse(optarg);
+        else if (opt == 'v')
+            csc_graph_verify = 1;
+        else
+            optind = argc;
     }
 
-    /* Write out the matrix */
-    /*
-    mm_write_banner(stdout, matcode);
-    mm_write_mtx_crd_size(stdout, M, N, nnz);
-    for (int i=0; i<nnz; i++)
-        fprintf(stdout, "%d %d %g   %d %d\n",
-                coo_row[i], coo_col[i], val[i], cooFull_row[nnz+i], cooFull_col[nnz+i]);
-    */
-
-    free(coo_row);
-    free(coo_col);
-    free(val);
-
-    int *csc_row = (int *)malloc((2*nnz)*sizeof(int));
-    int *csc_col = (int *)malloc((N+1)*sizeof(int));
+    if (nthreads < 1 || nthreads > MAX_THREAD || chunk < 1)
+        optind = argc;
 
-    coo2csc(csc_row, csc_col,
-            cooFull_row, cooFull_col,
-            2*nnz, N, 1);
+    if (optind != argc-1)
+	{
+		fprintf(stderr, "Usage: %s [-k masked|bitmap|dag|varint] [-s steal|chunk] [-t threads] [-c chunk] [-a auto|atomic|buffered] [-g galloping-ratio] [-b hub-degree] [-r none|degree|rcm|gorder] [-v] [martix-market-filename]\n", argv[0]);
+		exit(1);
+	}
+    const char *filename = argv[optind];
 
-    free(cooFull_row);
-    free(cooFull_col);
+    printf("Intersection: %s\n", intersect_init(NULL));
 
-    for(int i=0; i<N+1; i++){
-        quicksort(csc_row, csc_col[i], csc_col[i+1]-1);
-    }
+    csc_graph G;
+    if (csc_graph_load(filename, nthreads, order, &G) != 0)
+        exit(1);
+    N = G.N;
+    csc_row = G.csc_row;
+    csc_col = G.csc_col;
     
     // printf("csc_col: ");
     // for(int i=0; i<N+1; i++)
@@ -241,51 +307,202 @@ int main(int argc, char *argv[]){
     // printf("nnz: %d\n", nnz);
     
 
-    int c3[N];
 
-    for(int i=0; i<N; i++)
-        c3[i]=0;
+    int64_t *c3 = tc_counts_alloc(N);
+    if (c3 == NULL){
+        printf("Could not allocate the counts of %d vertices.\n", N);
+        exit(1);
+    }
 
 
     struct timespec start;
     struct timespec stop;
     struct timespec duration;
 
+    const char *dag_layout = NULL;
+    size_t dag_bytes = 0;
+    size_t varint_bytes = 0;
+
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-	pthread_t *threads;
-    pthread_attr_t pthread_custom_attr;
+    pthread_t threads[nthreads];
+    worker workers[nthreads];
+    parm p;
+    atomic_long cursor = 0;
+    atomic_long remaining = N;
+    long *cost = NULL;
+
+    p.n = N;
+    p.csc_row = csc_row;
+    p.csc_col = csc_col;
+    p.kernel = kernel;
+    p.chunk = chunk;
+    p.cursor = &cursor;
+    p.c3 = c3;
+    p.nworkers = nthreads;
+    p.workers = workers;
+    p.remaining = &remaining;
+
+    int nranges = nthreads*RANGES_PER_WORKER;
+    int bounds[nranges+1];
+
+    // ----- columns above this degree are counted against a bitmap
+    int bitmap_degree = INT_MAX;
+    if (kernel == KERNEL_BITMAP)
+        bitmap_degree = -1;
+    else if (intersect_hub_degree > 0 && kernel != KERNEL_VARINT)
+        bitmap_degree = intersect_hub_degree;
+
+    // ----- dag: any worker may credit any corner, through credit
+    tc_dag D;
+    tc_credit credit;
+    p.dag = NULL;
+    p.credit = NULL;
+    if (kernel == KERNEL_DAG){
+        if (tc_dag_build(csc_row, csc_col, N, &D) != 0){
+            printf("Could not allocate the DAG of %d vertices.\n", N);
+            exit(1);
+        }
+        dag_layout = tc_dag_width_name(D.width);
+        dag_bytes = tc_dag_bytes(&D);
+        if (tc_credit_init(&credit, N, nthreads, credit_mode, c3) != 0){
+            printf("Could not allocate the credits of %d vertices.\n", N);
+            exit(1);
+        }
+        p.dag = &D;
+        p.credit = &credit;
+    }
 
-    threads = (pthread_t *)malloc(N*sizeof(pthread_t));
-    pthread_attr_init(&pthread_custom_attr);
+    csc_varint V;
+    p.varint = NULL;
+    if (kernel == KERNEL_VARINT){
+        if (csc_varint_build(csc_row, csc_col, N, nthreads, &V) != 0){
+            printf("Could not allocate the compressed adjacency.\n");
+            exit(1);
+        }
+        p.varint = &V;
+        varint_bytes = csc_varint_bytes(&V);
+    }
 
-    parm *p = (parm *)malloc(N*sizeof(parm));
+    if (sched == SCHED_STEAL){
+        cost = (kernel == KERNEL_DAG) ?
+               tc_dag_cost(&D) :
+               tc_sched_cost(csc_row, csc_col, N, bitmap_degree);
+        if (cost == NULL){
+            printf("Could not allocate the work estimates, claiming chunks instead.\n");
+            sched = SCHED_CHUNK;
+        }
+    }
+    if (sched == SCHED_STEAL){
+        tc_sched_partition(cost, N, nranges, bounds);
+        p.cost = cost;
+        p.split_cost = cost[N] / ((long) nthreads*SPLITS_PER_WORKER);
+    }
 
-    for(int i=0; i<N; i++){
-        p[i].j = i;
-        p[i].csc_row = csc_row;
-        p[i].csc_col = csc_col;
-        p[i].c = 0;
-        pthread_create(&threads[i], &pthread_custom_attr, C, (void *)(p+i));
+    for(int t=0; t<nthreads; t++){
+        worker *w = &workers[t];
+        w->id = t;
+        w->p = &p;
+        w->ranges_done = 0;
+        w->steals = 0;
+        w->busy = 0;
+        w->idle = 0;
+        w->common = 0;
+        w->top = 0;
+        w->bottom = 0;
+        w->capacity = RANGES_PER_WORKER + DEQUE_SLACK;
+        w->ranges = (range *) malloc(w->capacity*sizeof(range));
+        if (w->ranges == NULL){
+            printf("Could not allocate the deques of %d workers.\n", nthreads);
+            exit(1);
+        }
+        pthread_mutex_init(&w->lock, NULL);
+
+        // ----- pushed last to first, so the owner starts at its first range
+        if (sched == SCHED_STEAL)
+            for(int k=RANGES_PER_WORKER-1; k>=0; k--){
+                range r = { bounds[t*RANGES_PER_WORKER + k], bounds[t*RANGES_PER_WORKER + k + 1] };
+                if (r.lo < r.hi)
+                    push_range(w, r);
+            }
+
+        // ----- the block of its own ranges, or an even share of the columns
+        if (sched == SCHED_STEAL){
+            w->touch_lo = bounds[t*RANGES_PER_WORKER];
+            w->touch_hi = bounds[(t+1)*RANGES_PER_WORKER];
+        }else{
+            w->touch_lo = (int)((int64_t) N * t / nthreads);
+            w->touch_hi = (int)((int64_t) N * (t+1) / nthreads);
+        }
     }
 
-    for(int i=0; i<N; i++){
-        pthread_join(threads[i],NULL);
-        c3[i] = p[i].c;
+    pthread_barrier_t touched;
+    pthread_barrier_init(&touched, NULL, nthreads);
+    p.touched = &touched;
+
+    void *(*fn)(void *) = (sched == SCHED_STEAL) ? steal_worker : C;
+
+    // ----- the main thread is the first worker of the pool
+    for(int t=1; t<nthreads; t++)
+        pthread_create(&threads[t], NULL, fn, (void *)&workers[t]);
+    fn((void *)&workers[0]);
+    for(int t=1; t<nthreads; t++)
+        pthread_join(threads[t], NULL);
+    pthread_barrier_destroy(&touched);
+
+    const char *credit_name = NULL;
+    if (kernel == KERNEL_DAG){
+        tc_credit_finish(&credit);
+        credit_name = tc_credit_name(&credit);
+        tc_credit_free(&credit);
+        tc_dag_free(&D);
     }
+    if (p.varint != NULL)
+        csc_varint_free(&V);
 
     clock_gettime(CLOCK_MONOTONIC, &stop);
 
-    free(csc_row);
-    free(csc_col);
-    free(p);
-
+    intersect_stats stats;
+    intersect_get_stats(&stats);
+    printf("Intersections: %ld merged, %ld galloping, %ld against bitmaps",
+           stats.merge, stats.galloping, stats.bitmap);
+    printf(" (galloping ratio %d, hub degree %d)\n", intersect_skew, intersect_hub_degree);
+    if (sched == SCHED_STEAL)
+        printf("Workers: %d threads, work stealing from %d ranges\n", nthreads, nranges);
+    else
+        printf("Workers: %d threads, chunks of %d columns\n", nthreads, chunk);
+    long common = 0;
+    for(int t=0; t<nthreads; t++){
+        printf("  worker %d: %ld ranges, %ld steals, busy %.3f s, idle %.3f s\n",
+               t, workers[t].ranges_done, workers[t].steals, workers[t].busy, workers[t].idle);
+        common += workers[t].common;
+        pthread_mutex_destroy(&workers[t].lock);
+        free(workers[t].ranges);
+    }
+    free(cost);
+    if (credit_name != NULL)
+        printf("Credits: %s\n", credit_name);
+    printf("Triangles: %ld\n", kernel == KERNEL_DAG ? common : common/6);
+    intersect_free_scratch();
+
+    printf("Memory: %.1f MB of CSC, %.1f MB of counts, %.1f MB peak resident\n",
+           csc_graph_bytes(&G)/(1024.0*1024.0),
+           tc_counts_bytes(N)/(1024.0*1024.0), tc_peak_rss()/(1024.0*1024.0));
+    if (dag_layout != NULL)
+        printf("DAG: %s, %.1f MB\n", dag_layout, dag_bytes/(1024.0*1024.0));
+    if (varint_bytes > 0)
+        printf("Varint: %.1f MB, %.2fx smaller than the CSC\n", varint_bytes/(1024.0*1024.0),
+               csc_graph_bytes(&G)/(double) varint_bytes);
+
+    csc_graph_restore(&G, c3);
+    csc_graph_free(&G);
+
+    // ----- the masked product finds every triangle twice per vertex
     printf("\nC3:\n");
     for(int i=0; i<N; i++){
-        if(c3[i]%2 != 0)
-            c3[i]++;
-        c3[i] = c3[i]/2;
-        printf("%d %d\n", i, c3[i]);
+        if (kernel != KERNEL_DAG)
+            c3[i] = c3[i]/2;
+        printf("%d %" PRId64 "\n", i, c3[i]);
     }
 
     duration.tv_sec = stop.tv_sec - start.tv_sec;
@@ -301,6 +518,8 @@ int main(int argc, char *argv[]){
 
     printf("The process took %ld seconds and %ld nanoseconds", duration.tv_sec, duration.tv_nsec);
 
+    tc_counts_free(c3, N);
+
 
 	return 0;
 }